@@ -162,6 +162,33 @@ struct ScriptAnyValue
 	}
 };
 
+////////////////////////////////////////////////////////////////////////////
+// Description:
+//    Type of a field written by IScriptTable::FillRecord.
+enum class ScriptRecordFieldType
+{
+	BOOL,    // bool
+	INT,     // int
+	FLOAT,   // float
+	HANDLE,  // int or EntityId stored as ScriptHandle
+	VEC3,    // Vec3, existing vector table is reused
+};
+
+struct ScriptRecordField
+{
+	const char *key;
+	ScriptRecordFieldType type;
+	size_t offset;  // offset of the field in the structure, e.g. offsetof(HitInfo, pos)
+};
+
+// Description:
+//    Describes how to write fields of a C++ structure into a script table.
+//    Created by IScriptSystem::CreateRecordSchema.
+struct IScriptRecordSchema
+{
+	virtual void Release() = 0;
+};
+
 ////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////
 // Summary
@@ -417,6 +444,10 @@ struct IScriptSystem
 
 	// Retrieve size of memory allocated in script.
 	virtual uint32 GetScriptAllocSize() = 0;
+
+	// Description:
+	//    Creates a schema for IScriptTable::FillRecord. The keys are interned once here.
+	virtual IScriptRecordSchema *CreateRecordSchema( const ScriptRecordField *pFields,int nFieldCount ) = 0;
 };
 
 ////////////////////////////////////////////////////////////////////////////
@@ -587,6 +618,10 @@ struct IScriptTable
 	//! @param szPath e.g. "cnt.table1.table2", "", "mytable", max 255 characters
 	//! @return true=path was valid, false otherwise
 	virtual bool GetValueRecursive( const char *szPath, IScriptTable *pObj ) = 0;
+
+	// Description:
+	//    Writes all fields of the record described by the schema in one go.
+	virtual void FillRecord( const IScriptRecordSchema *pSchema,const void *pRecord,bool bChain=false ) = 0;
 };
 
 
@@ -366,6 +366,10 @@ int CGame::Update(bool haveFocus, unsigned int updateFlags)
 
 	m_pFramework->PostUpdate(true, updateFlags);
 
+	// synched storage changes of this frame go out together
+	if (gEnv->bServer && m_pServerSynchedStorage)
+		m_pServerSynchedStorage->Flush();
+
 	CheckReloadLevel();
 
 	return bRun ? 1 : 0;
@@ -517,6 +517,8 @@ void SCVars::InitCVars(IConsole* pConsole)
 	pConsole->Register("tracer_min_scale", &tracer_min_scale, 0.5f, 0, "Scale at min distance.");
 	pConsole->Register("tracer_max_scale", &tracer_max_scale, 5.0f, 0, "Scale at max distance.");
 	pConsole->Register("tracer_max_count", &tracer_max_count, 32, 0, "Max number of active tracers.");
+	pConsole->Register("tracer_max_emit_per_frame", &tracer_max_emit_per_frame, 16, 0, "Max number of tracers started in one frame, 0 is unlimited.");
+	pConsole->Register("tracer_cull_distance", &tracer_cull_distance, 300.0f, 0, "Tracers passing farther than this from the camera are not shown, 0 disables culling.");
 	pConsole->Register("tracer_player_radiusSqr", &tracer_player_radiusSqr, 400.0f, 0, "Sqr Distance around player at which to start decelerate/acelerate tracer speed.");
 
 	pConsole->Register("i_debug_projectiles", &i_debug_projectiles, 0, VF_CHEAT, "Displays info about projectile status, where available.");
@@ -587,6 +589,12 @@ void SCVars::InitCVars(IConsole* pConsole)
 	pConsole->Register("g_MPDeathEffects", &g_deathEffects, 0, 0, "Enables / disables the MP death screen-effects");
 
 	pConsole->Register("sv_pacifist", &sv_pacifist, 0, 0, "Pacifist mode (only works on dedicated server)");
+	pConsole->Register("sv_hitBatching", &sv_hitBatching, 0, 0,
+		"Gathers server hits and processes them once per frame.\n"
+		"The server state script receives them in one OnHits call if it defines it, OnHit is called per hit otherwise.");
+	pConsole->Register("sv_nativeHitDamage", &sv_nativeHitDamage, 0, 0,
+		"Applies non-lethal bullet damage to actors without calling the hit script.\n"
+		"Head hits, armor mode, friendly fire and kills are still handled by the script.");
 
 	pVehicleQuality = pConsole->GetCVar("v_vehicle_quality");		assert(pVehicleQuality);
 
@@ -888,6 +896,8 @@ void SCVars::ReleaseCVars()
 	pConsole->UnregisterVariable("tracer_min_scale", true);
 	pConsole->UnregisterVariable("tracer_max_scale", true);
 	pConsole->UnregisterVariable("tracer_max_count", true);
+	pConsole->UnregisterVariable("tracer_max_emit_per_frame", true);
+	pConsole->UnregisterVariable("tracer_cull_distance", true);
 	pConsole->UnregisterVariable("tracer_player_radiusSqr", true);
 
 	pConsole->UnregisterVariable("i_debug_projectiles", true);
@@ -159,6 +159,8 @@ struct SCVars
 	int		g_useHitSoundFeedback;
 
 	int sv_pacifist;
+	int sv_hitBatching;
+	int sv_nativeHitDamage;
 
 	int g_empStyle;
 	float g_empNanosuitDowntime;
@@ -389,6 +391,8 @@ struct SCVars
 	float	tracer_min_scale;
 	float	tracer_max_scale;
 	int		tracer_max_count;
+	int		tracer_max_emit_per_frame;
+	float	tracer_cull_distance;
 	float	tracer_player_radiusSqr;
 	int		i_debug_projectiles;
 	int		i_auto_turret_target;
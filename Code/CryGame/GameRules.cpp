@@ -76,6 +76,7 @@ CGameRules::CGameRules()
 	m_ignoreEntityNextCollision(0),
 	m_timeOfDayInitialized(false),
 	m_processingHit(0),
+	m_scriptHitBatchSize(0),
 	m_explosionScreenFX(true),
 	m_pShotValidator(0)
 {
@@ -141,6 +142,7 @@ bool CGameRules::Init(IGameObject* pGameObject)
 	m_serverStateScript = m_serverScript;
 
 	m_scriptHitInfo.Create(gEnv->pScriptSystem);
+	CreateScriptHitBatch();
 	m_scriptExplosionInfo.Create(gEnv->pScriptSystem);
 	SmartScriptTable affected(gEnv->pScriptSystem);
 	m_scriptExplosionInfo->SetValue("AffectedEntities", affected);
@@ -317,6 +319,7 @@ void CGameRules::Update(SEntityUpdateContext& ctx, int updateSlot)
 	if (server)
 	{
 		ProcessQueuedExplosions();
+		FlushServerHits();
 		UpdateEntitySchedules(ctx.fFrameTime);
 
 		if (m_pShotValidator)
@@ -390,6 +393,7 @@ void CGameRules::ProcessEvent(SEntityEvent& event)
 
 		while (!m_queuedHits.empty())
 			m_queuedHits.pop();
+		m_pendingHits.clear();
 		m_processingHit = 0;
 
 		// TODO: move this from here
@@ -538,7 +542,7 @@ void CGameRules::OnResetMap()
 	if (!gEnv->bServer)
 	{
 		m_objectives.clear();
-		m_entityteams.clear();
+		ClearEntityTeams();
 
 		for (TPlayerTeamIdMap::iterator tit = m_playerteams.begin(); tit != m_playerteams.end(); tit++)
 			tit->second.resize(0);
@@ -1435,7 +1439,13 @@ void CGameRules::RemoveTeam(int teamId)
 	for (TEntityTeamIdMap::iterator eit = m_entityteams.begin(); eit != m_entityteams.end(); ++eit)
 	{
 		if (eit->second == teamId)
+		{
 			eit->second = 0; // 0 is no team
+
+			SEntityTeamSlot& slot = m_entityteamslots[eit->first & 0xFFFF];
+			if (slot.entityId == eit->first)
+				slot.teamId = 0;
+		}
 	}
 
 	m_playerteams.erase(m_playerteams.find(teamId));
@@ -1548,9 +1558,7 @@ void CGameRules::SetTeam(int teamId, EntityId id)
 	if (oldTeam == teamId)
 		return;
 
-	TEntityTeamIdMap::iterator it = m_entityteams.find(id);
-	if (it != m_entityteams.end())
-		m_entityteams.erase(it);
+	SetEntityTeam(id, teamId);
 
 	IActor* pActor = m_pActorSystem->GetActor(id);
 	bool isplayer = pActor != 0;
@@ -1563,8 +1571,6 @@ void CGameRules::SetTeam(int teamId, EntityId id)
 
 	if (teamId)
 	{
-		m_entityteams.insert(TEntityTeamIdMap::value_type(id, teamId));
-
 		if (isplayer)
 		{
 			TPlayerTeamIdMap::iterator pit = m_playerteams.find(teamId);
@@ -1636,13 +1642,45 @@ void CGameRules::SetTeam(int teamId, EntityId id)
 //------------------------------------------------------------------------
 int CGameRules::GetTeam(EntityId entityId) const
 {
-	TEntityTeamIdMap::const_iterator it = m_entityteams.find(entityId);
-	if (it != m_entityteams.end())
-		return it->second;
+	const size_t index = entityId & 0xFFFF;
+	if (index < m_entityteamslots.size() && m_entityteamslots[index].entityId == entityId)
+		return m_entityteamslots[index].teamId;
 
 	return 0;
 }
 
+//------------------------------------------------------------------------
+void CGameRules::SetEntityTeam(EntityId entityId, int teamId)
+{
+	const size_t index = entityId & 0xFFFF;
+
+	if (teamId)
+	{
+		m_entityteams[entityId] = teamId;
+
+		if (index >= m_entityteamslots.size())
+			m_entityteamslots.resize(index + 1);
+
+		m_entityteamslots[index].entityId = entityId;
+		m_entityteamslots[index].teamId = teamId;
+	}
+	else
+	{
+		m_entityteams.erase(entityId);
+
+		// the slot may belong to a newer entity with the same index already
+		if (index < m_entityteamslots.size() && m_entityteamslots[index].entityId == entityId)
+			m_entityteamslots[index] = SEntityTeamSlot();
+	}
+}
+
+//------------------------------------------------------------------------
+void CGameRules::ClearEntityTeams()
+{
+	m_entityteams.clear();
+	m_entityteamslots.clear();
+}
+
 //------------------------------------------------------------------------
 int CGameRules::GetChannelTeam(int channelId) const
 {
@@ -3257,19 +3295,32 @@ void CGameRules::CmdDebugObjectives(IConsoleCmdArgs* pArgs)
 //------------------------------------------------------------------------
 void CGameRules::CreateScriptHitInfo(SmartScriptTable& scriptHitInfo, const HitInfo& hitInfo)
 {
+	// plain fields of the hit are written in one pass with pre-interned keys
+	static const ScriptRecordField fields[] = {
+		{ "normal", ScriptRecordFieldType::VEC3, offsetof(HitInfo, normal) },
+		{ "pos", ScriptRecordFieldType::VEC3, offsetof(HitInfo, pos) },
+		{ "dir", ScriptRecordFieldType::VEC3, offsetof(HitInfo, dir) },
+		{ "partId", ScriptRecordFieldType::INT, offsetof(HitInfo, partId) },
+		{ "targetId", ScriptRecordFieldType::HANDLE, offsetof(HitInfo, targetId) },
+		{ "shooterId", ScriptRecordFieldType::HANDLE, offsetof(HitInfo, shooterId) },
+		{ "weaponId", ScriptRecordFieldType::HANDLE, offsetof(HitInfo, weaponId) },
+		{ "projectileId", ScriptRecordFieldType::HANDLE, offsetof(HitInfo, projectileId) },
+		{ "fmId", ScriptRecordFieldType::HANDLE, offsetof(HitInfo, fmId) },
+		{ "materialId", ScriptRecordFieldType::INT, offsetof(HitInfo, material) },
+		{ "damage", ScriptRecordFieldType::FLOAT, offsetof(HitInfo, damage) },
+		{ "radius", ScriptRecordFieldType::FLOAT, offsetof(HitInfo, radius) },
+		{ "typeId", ScriptRecordFieldType::INT, offsetof(HitInfo, type) },
+		{ "remote", ScriptRecordFieldType::BOOL, offsetof(HitInfo, remote) },
+		{ "bulletType", ScriptRecordFieldType::INT, offsetof(HitInfo, bulletType) },
+	};
+	static IScriptRecordSchema *pSchema = m_pScriptSystem->CreateRecordSchema(fields, sizeof(fields) / sizeof(fields[0]));
+
 	CScriptSetGetChain hit(scriptHitInfo);
 	{
-		hit.SetValue("normal", hitInfo.normal);
-		hit.SetValue("pos", hitInfo.pos);
-		hit.SetValue("dir", hitInfo.dir);
-		hit.SetValue("partId", hitInfo.partId);
-		hit.SetValue("backface", hitInfo.normal.Dot(hitInfo.dir) >= 0.0f);
+		const bool isChain = true;
+		scriptHitInfo->FillRecord(pSchema, &hitInfo, isChain);
 
-		hit.SetValue("targetId", ScriptHandle(hitInfo.targetId));
-		hit.SetValue("shooterId", ScriptHandle(hitInfo.shooterId));
-		hit.SetValue("weaponId", ScriptHandle(hitInfo.weaponId));
-		hit.SetValue("projectileId", ScriptHandle(hitInfo.projectileId));
-		hit.SetValue("fmId", ScriptHandle(hitInfo.fmId));
+		hit.SetValue("backface", hitInfo.normal.Dot(hitInfo.dir) >= 0.0f);
 
 		IEntity* pTarget = m_pEntitySystem->GetEntity(hitInfo.targetId);
 		IEntity* pShooter = m_pEntitySystem->GetEntity(hitInfo.shooterId);
@@ -3282,8 +3333,6 @@ void CGameRules::CreateScriptHitInfo(SmartScriptTable& scriptHitInfo, const HitI
 		hit.SetValue("weapon", pWeapon ? pWeapon->GetScriptTable() : (IScriptTable*)0);
 		//hit.SetValue("projectile_class", pProjectile?pProjectile->GetClass()->GetName():"");
 
-		hit.SetValue("materialId", hitInfo.material);
-
 		ISurfaceType* pSurfaceType = GetHitMaterial(hitInfo.material);
 		if (pSurfaceType)
 		{
@@ -3296,14 +3345,8 @@ void CGameRules::CreateScriptHitInfo(SmartScriptTable& scriptHitInfo, const HitI
 			hit.SetToNull("material_type");
 		}
 
-		hit.SetValue("damage", hitInfo.damage);
-		hit.SetValue("radius", hitInfo.radius);
-
-		hit.SetValue("typeId", hitInfo.type);
 		const char* type = GetHitType(hitInfo.type);
 		hit.SetValue("type", type ? type : "");
-		hit.SetValue("remote", hitInfo.remote);
-		hit.SetValue("bulletType", hitInfo.bulletType);
 
 		// Check for hit assistance
 		float assist = 0.0f;
@@ -3561,6 +3604,7 @@ void CGameRules::ResetEntities()
 
 	while (!m_queuedHits.empty())
 		m_queuedHits.pop();
+	m_pendingHits.clear();
 	m_processingHit = 0;
 
 	// remove voice groups too. They'll be recreated when players are put back on their teams after reset.
@@ -3574,7 +3618,7 @@ void CGameRules::ResetEntities()
 	}
 
 	m_respawns.clear();
-	m_entityteams.clear();
+	ClearEntityTeams();
 	m_teamdefaultspawns.clear();
 
 	for (TPlayerTeamIdMap::iterator tit = m_playerteams.begin(); tit != m_playerteams.end(); tit++)
@@ -4027,6 +4071,7 @@ void CGameRules::GetMemoryStatistics(ICrySizer* s)
 	s->AddContainer(m_channelIds);
 	s->AddContainer(m_teams);
 	s->AddContainer(m_entityteams);
+	s->AddContainer(m_entityteamslots);
 	s->AddContainer(m_channelteams);
 	s->AddContainer(m_teamdefaultspawns);
 	s->AddContainer(m_playerteams);
@@ -403,6 +403,8 @@ public:
   virtual void ClientHit(const HitInfo &hitInfo);
 	virtual void ServerHit(const HitInfo &hitInfo);
 	virtual void ProcessServerHit(HitInfo &hitInfo);
+	// sv_hitBatching, processes the hits gathered since the last frame
+	void FlushServerHits();
 
 	void CullEntitiesInExplosion(const ExplosionInfo &explosionInfo);
 	virtual void ServerExplosion(const ExplosionInfo &explosionInfo);
@@ -960,6 +962,15 @@ public:
 
 	typedef std::map<int, EntityId>				TTeamIdEntityIdMap;
 	typedef std::map<EntityId, int>				TEntityTeamIdMap;
+
+	// flat copy of m_entityteams for GetTeam, indexed by the entity index in the low 16 bits of the id
+	// the full id is compared, so slots of removed entities never match their successors
+	struct SEntityTeamSlot
+	{
+		EntityId	entityId = 0;
+		int				teamId = 0;
+	};
+	typedef std::vector<SEntityTeamSlot>	TEntityTeamSlots;
 	typedef std::map<int, TPlayers>				TPlayerTeamIdMap;
 	typedef std::map<int, EntityId>				TChannelTeamIdMap;
 	typedef std::map<string, int>					TTeamIdMap;
@@ -1013,6 +1024,19 @@ protected:
 	static void CmdDebugObjectives(IConsoleCmdArgs *pArgs);
 
 	void CreateScriptHitInfo(SmartScriptTable &scriptHitInfo, const HitInfo &hitInfo);
+	// keep m_entityteams and m_entityteamslots in sync, team 0 removes the entity
+	void SetEntityTeam(EntityId entityId, int teamId);
+	void ClearEntityTeams();
+
+	void CreateScriptHitBatch();
+	void FillScriptHitBatch(const std::vector<HitInfo> &hits);
+
+	// validation and dead shooter/spectator target checks
+	bool AcceptServerHit(HitInfo &hitInfo);
+	// sv_nativeHitDamage, returns false if the hit must go to the script
+	bool ApplyNativeHitDamage(const HitInfo &hitInfo);
+	// hit listeners and gameplay recorder
+	void NotifyServerHit(const HitInfo &hitInfo);
 	void CreateScriptExplosionInfo(SmartScriptTable &scriptExplosionInfo, const ExplosionInfo &explosionInfo);
 	void UpdateAffectedEntitiesSet(TExplosionAffectedEntities &affectedEnts, const pe_explosion *pExplosion);
 	void AddOrUpdateAffectedEntity(TExplosionAffectedEntities &affectedEnts, IEntity* pEntity, float affected);
@@ -1112,6 +1136,7 @@ protected:
 	
 	TTeamIdMap					m_teams;
 	TEntityTeamIdMap		m_entityteams;
+	TEntityTeamSlots		m_entityteamslots;
 	TTeamIdEntityIdMap	m_teamdefaultspawns;
 	TPlayerTeamIdMap		m_playerteams;
 	TChannelTeamIdMap		m_channelteams;
@@ -1133,6 +1158,30 @@ protected:
 	THitQueue						m_queuedHits;
 	int									m_processingHit;	
 
+	// columns of the OnHits table, indexed from 1 up to its "count" field
+	enum EScriptHitColumn
+	{
+		eSHC_TargetId,
+		eSHC_ShooterId,
+		eSHC_WeaponId,
+		eSHC_ProjectileId,
+		eSHC_Damage,
+		eSHC_TypeId,
+		eSHC_MaterialId,
+		eSHC_PartId,
+		eSHC_Pos,
+		eSHC_Dir,
+		eSHC_Normal,
+
+		eSHC_Last
+	};
+
+	std::vector<HitInfo>	m_pendingHits;
+	std::vector<HitInfo>	m_scriptHits;
+	SmartScriptTable		m_scriptHitBatch;
+	SmartScriptTable		m_scriptHitColumns[eSHC_Last];
+	int									m_scriptHitBatchSize;
+
 	TEntityRespawnDataMap	m_respawndata;
 	TEntityRespawnMap			m_respawns;
 	TEntityRemovalMap			m_removals;
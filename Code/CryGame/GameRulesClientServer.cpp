@@ -236,6 +236,15 @@ void CGameRules::ServerHit(const HitInfo& hitInfo)
 		}
 	}
 
+	// hits released by the shot validator were delayed already and must not be validated twice
+	const bool isValidated = m_pShotValidator && m_pShotValidator->IsReleasingHit();
+
+	if (g_pGameCVars->sv_hitBatching && !m_processingHit && !isValidated)
+	{
+		m_pendingHits.push_back(info);
+		return;
+	}
+
 	if (m_processingHit)
 	{
 		m_queuedHits.push(info);
@@ -259,56 +268,233 @@ void CGameRules::ServerHit(const HitInfo& hitInfo)
 //------------------------------------------------------------------------
 void CGameRules::ProcessServerHit(HitInfo& hitInfo)
 {
-	if (m_pShotValidator && !m_pShotValidator->ProcessHit(hitInfo))
+	if (!AcceptServerHit(hitInfo))
 		return;
 
-	bool ok = true;
-	// check if shooter is alive
-	CActor* pShooter = GetActorByEntityId(hitInfo.shooterId);
+	if (!ApplyNativeHitDamage(hitInfo))
+	{
+		CreateScriptHitInfo(m_scriptHitInfo, hitInfo);
+		CallScript(m_serverStateScript, "OnHit", m_scriptHitInfo);
+	}
+
+	NotifyServerHit(hitInfo);
+}
+
+//------------------------------------------------------------------------
+void CGameRules::FlushServerHits()
+{
+	if (m_pendingHits.empty())
+		return;
+
+	FUNCTION_PROFILER(GetISystem(), PROFILE_GAME);
+
+	// hits caused by the script are queued and processed one by one below
+	++m_processingHit;
+
+	const bool hasBatchHandler = m_serverStateScript.GetPtr() && m_serverStateScript->GetValueType("OnHits") == svtFunction;
+
+	if (hasBatchHandler)
+	{
+		m_scriptHits.clear();
+
+		for (HitInfo& hitInfo : m_pendingHits)
+		{
+			if (!AcceptServerHit(hitInfo))
+				continue;
 
+			if (ApplyNativeHitDamage(hitInfo))
+				NotifyServerHit(hitInfo);
+			else
+				m_scriptHits.push_back(hitInfo);
+		}
+
+		if (!m_scriptHits.empty())
+		{
+			FillScriptHitBatch(m_scriptHits);
+			CallScript(m_serverStateScript, "OnHits", m_scriptHitBatch);
+
+			for (const HitInfo& hitInfo : m_scriptHits)
+				NotifyServerHit(hitInfo);
+		}
+	}
+	else
+	{
+		for (HitInfo& hitInfo : m_pendingHits)
+			ProcessServerHit(hitInfo);
+	}
+
+	m_pendingHits.clear();
+
+	while (!m_queuedHits.empty())
+	{
+		HitInfo qinfo(m_queuedHits.front());
+		ProcessServerHit(qinfo);
+		m_queuedHits.pop();
+	}
+
+	--m_processingHit;
+}
+
+//------------------------------------------------------------------------
+bool CGameRules::AcceptServerHit(HitInfo& hitInfo)
+{
+	if (m_pShotValidator && !m_pShotValidator->ProcessHit(hitInfo))
+		return false;
+
+	// check if shooter is alive
 	if (hitInfo.shooterId)
 	{
+		CActor* pShooter = GetActorByEntityId(hitInfo.shooterId);
 		if (pShooter && pShooter->GetHealth() <= 0)
-			ok = false;
+			return false;
 	}
 
 	if (hitInfo.targetId)
 	{
 		CActor* pTarget = GetActorByEntityId(hitInfo.targetId);
 		if (pTarget && pTarget->GetSpectatorMode())
-			ok = false;
+			return false;
 	}
 
-	if (ok)
+	return true;
+}
+
+//------------------------------------------------------------------------
+bool CGameRules::ApplyNativeHitDamage(const HitInfo& hitInfo)
+{
+	if (!g_pGameCVars->sv_nativeHitDamage)
+		return false;
+
+	const int bulletTypeId = GetHitTypeId("bullet");
+	if (!bulletTypeId || hitInfo.type != bulletTypeId || hitInfo.damage <= 0.0f || !hitInfo.targetId || hitInfo.targetId == hitInfo.shooterId)
+		return false;
+
+	CActor* pTarget = GetActorByEntityId(hitInfo.targetId);
+	if (!pTarget || pTarget->GetHealth() <= 0 || pTarget->IsGod() > 0)
+		return false;
+
+	// friendly fire rules are up to the script
+	const int targetTeamId = GetTeam(hitInfo.targetId);
+	if (targetTeamId != 0 && targetTeamId == GetTeam(hitInfo.shooterId))
+		return false;
+
+	// head hits usually have their own damage multipliers
+	if (ISurfaceType* pSurfaceType = GetHitMaterial(hitInfo.material))
 	{
-		CreateScriptHitInfo(m_scriptHitInfo, hitInfo);
-		CallScript(m_serverStateScript, "OnHit", m_scriptHitInfo);
+		if (!strcmp(pSurfaceType->GetType(), "head"))
+			return false;
+	}
 
-		// call hit listeners if any
-		if (m_hitListeners.empty() == false)
-		{
-			THitListenerVec::iterator iter = m_hitListeners.begin();
-			while (iter != m_hitListeners.end())
-			{
-				(*iter)->OnHit(hitInfo);
-				++iter;
-			}
-		}
+	// armor absorption is done by the script
+	if (pTarget->IsPlayer() && pTarget->GetActorClass() == CPlayer::GetActorClassType())
+	{
+		CNanoSuit* pSuit = static_cast<CPlayer*>(pTarget)->GetNanoSuit();
+		if (pSuit && (pSuit->IsInvulnerable() || pSuit->GetMode() == NANOMODE_DEFENSE))
+			return false;
+	}
+
+	// kills go through the script to keep its score and respawn logic
+	const int health = pTarget->GetHealth() - static_cast<int>(hitInfo.damage);
+	if (health <= 0)
+		return false;
+
+	pTarget->SetHealth(health);
+	pTarget->DamageInfo(hitInfo.shooterId, hitInfo.weaponId, hitInfo.damage, "bullet");
+
+	return true;
+}
 
-		if (pShooter && hitInfo.shooterId != hitInfo.targetId && hitInfo.weaponId != hitInfo.shooterId && hitInfo.weaponId != hitInfo.targetId && hitInfo.damage >= 0)
+//------------------------------------------------------------------------
+void CGameRules::NotifyServerHit(const HitInfo& hitInfo)
+{
+	// call hit listeners if any
+	if (m_hitListeners.empty() == false)
+	{
+		THitListenerVec::iterator iter = m_hitListeners.begin();
+		while (iter != m_hitListeners.end())
 		{
-			EntityId params[2];
-			params[0] = hitInfo.weaponId;
-			params[1] = hitInfo.targetId;
-			m_pGameplayRecorder->Event(pShooter->GetEntity(), GameplayEvent(eGE_WeaponHit, 0, 0, (void*)params));
+			(*iter)->OnHit(hitInfo);
+			++iter;
 		}
+	}
+
+	CActor* pShooter = GetActorByEntityId(hitInfo.shooterId);
+	if (!pShooter)
+		return;
+
+	if (hitInfo.shooterId != hitInfo.targetId && hitInfo.weaponId != hitInfo.shooterId && hitInfo.weaponId != hitInfo.targetId && hitInfo.damage >= 0)
+	{
+		EntityId params[2];
+		params[0] = hitInfo.weaponId;
+		params[1] = hitInfo.targetId;
+		m_pGameplayRecorder->Event(pShooter->GetEntity(), GameplayEvent(eGE_WeaponHit, 0, 0, (void*)params));
+	}
+
+	m_pGameplayRecorder->Event(pShooter->GetEntity(), GameplayEvent(eGE_Hit, 0, 0, (void*)hitInfo.weaponId));
+	m_pGameplayRecorder->Event(pShooter->GetEntity(), GameplayEvent(eGE_Damage, 0, hitInfo.damage, (void*)hitInfo.weaponId));
+}
+
+//------------------------------------------------------------------------
+void CGameRules::CreateScriptHitBatch()
+{
+	static const char* const columnNames[eSHC_Last] = {
+		"targetId",
+		"shooterId",
+		"weaponId",
+		"projectileId",
+		"damage",
+		"typeId",
+		"materialId",
+		"partId",
+		"pos",
+		"dir",
+		"normal",
+	};
+
+	m_scriptHitBatch.Create(gEnv->pScriptSystem);
+	m_scriptHitBatch->SetValue("count", 0);
+
+	for (int i = 0; i < eSHC_Last; i++)
+	{
+		m_scriptHitColumns[i].Create(gEnv->pScriptSystem);
+		m_scriptHitBatch->SetValue(columnNames[i], m_scriptHitColumns[i]);
+	}
 
-		if (pShooter)
-			m_pGameplayRecorder->Event(pShooter->GetEntity(), GameplayEvent(eGE_Hit, 0, 0, (void*)hitInfo.weaponId));
+	m_scriptHitBatchSize = 0;
+}
 
-		if (pShooter)
-			m_pGameplayRecorder->Event(pShooter->GetEntity(), GameplayEvent(eGE_Damage, 0, hitInfo.damage, (void*)hitInfo.weaponId));
+//------------------------------------------------------------------------
+void CGameRules::FillScriptHitBatch(const std::vector<HitInfo>& hits)
+{
+	const int count = static_cast<int>(hits.size());
+
+	for (int i = 0; i < count; i++)
+	{
+		const HitInfo& hitInfo = hits[i];
+		const int index = i + 1;
+
+		m_scriptHitColumns[eSHC_TargetId]->SetAt(index, ScriptHandle(hitInfo.targetId));
+		m_scriptHitColumns[eSHC_ShooterId]->SetAt(index, ScriptHandle(hitInfo.shooterId));
+		m_scriptHitColumns[eSHC_WeaponId]->SetAt(index, ScriptHandle(hitInfo.weaponId));
+		m_scriptHitColumns[eSHC_ProjectileId]->SetAt(index, ScriptHandle(hitInfo.projectileId));
+		m_scriptHitColumns[eSHC_Damage]->SetAt(index, hitInfo.damage);
+		m_scriptHitColumns[eSHC_TypeId]->SetAt(index, hitInfo.type);
+		m_scriptHitColumns[eSHC_MaterialId]->SetAt(index, hitInfo.material);
+		m_scriptHitColumns[eSHC_PartId]->SetAt(index, hitInfo.partId);
+		m_scriptHitColumns[eSHC_Pos]->SetAt(index, hitInfo.pos);
+		m_scriptHitColumns[eSHC_Dir]->SetAt(index, hitInfo.dir);
+		m_scriptHitColumns[eSHC_Normal]->SetAt(index, hitInfo.normal);
+	}
+
+	// drop what is left from a larger previous batch
+	for (int index = count + 1; index <= m_scriptHitBatchSize; index++)
+	{
+		for (int column = 0; column < eSHC_Last; column++)
+			m_scriptHitColumns[column]->SetNullAt(index);
 	}
+
+	m_scriptHitBatchSize = count;
+	m_scriptHitBatch->SetValue("count", count);
 }
 
 //------------------------------------------------------------------------
@@ -881,9 +1067,7 @@ IMPLEMENT_RMI(CGameRules, ClSetTeam)
 	if (oldTeam == params.teamId)
 		return true;
 
-	TEntityTeamIdMap::iterator it = m_entityteams.find(params.entityId);
-	if (it != m_entityteams.end())
-		m_entityteams.erase(it);
+	SetEntityTeam(params.entityId, params.teamId);
 
 	IActor* pActor = m_pActorSystem->GetActor(params.entityId);
 	bool isplayer = pActor != 0;
@@ -896,7 +1080,6 @@ IMPLEMENT_RMI(CGameRules, ClSetTeam)
 
 	if (params.teamId)
 	{
-		m_entityteams.insert(TEntityTeamIdMap::value_type(params.entityId, params.teamId));
 		if (isplayer)
 		{
 			TPlayerTeamIdMap::iterator pit = m_playerteams.find(params.teamId);
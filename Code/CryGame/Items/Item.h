@@ -818,6 +818,7 @@ public:
 		return m_modifying; 
 	}
   virtual bool IsDestroyed() { return m_properties.hitpoints > 0 && m_stats.health <= 0.f; }
+	bool IsFrozen() const { return m_frozen; }
 
 	virtual void EnterWater(bool enter) {};
 	// ~IItem
@@ -10,6 +10,8 @@ History:
 - 1:9:2005   11:32 : Created by Márcio Martins
 
 *************************************************************************/
+#include <algorithm>
+
 #include "CryCommon/CrySystem/ISystem.h"
 #include "ItemScheduler.h"
 #include "Item.h"
@@ -17,12 +19,17 @@ History:
 #include "CryCommon/CryAction/IGameObject.h"
 
 
+CItemScheduler::TWakeUpVector CItemScheduler::s_wakeUps;
+double CItemScheduler::s_time = 0.0;
+unsigned int CItemScheduler::s_sequence = 0;
+
 //------------------------------------------------------------------------
 CItemScheduler::CItemScheduler(CItem *item)
 : m_busy(false),
 	m_pTimer(0),
 	m_pItem(item),
-	m_locked(false)
+	m_locked(false),
+	m_wakeUpTime(-1.0)
 {
 	m_pTimer = gEnv->pTimer;
 }
@@ -31,20 +38,29 @@ CItemScheduler::CItemScheduler(CItem *item)
 CItemScheduler::~CItemScheduler()
 {
 	Reset();
+	RemoveWakeUps();
 }
 
 //------------------------------------------------------------------------
 void CItemScheduler::Reset(bool keepPersistent)
 {
-	for (TTimerActionVector::iterator it = m_timers.begin(); it != m_timers.end();)
+	if (!m_timers.empty())
 	{
-		if (!it->persist || !keepPersistent)
+		size_t count = 0;
+		for (size_t i = 0; i < m_timers.size(); i++)
 		{
-			it->action->destroy();
-			it = m_timers.erase(it);
+			if (!m_timers[i].persist || !keepPersistent)
+				m_timers[i].action->destroy();
+			else
+				m_timers[count++] = m_timers[i];
 		}
-		else
-			it++;
+
+		m_timers.resize(count);
+		std::make_heap(m_timers.begin(), m_timers.end(), compare_timers());
+
+		// a remaining wake-up may now come early, which only costs a look at the heap
+		if (m_timers.empty())
+			m_wakeUpTime = -1.0;
 	}
 
 	for (TScheduledActionVector::iterator it = m_schedule.begin(); it != m_schedule.end();)
@@ -58,7 +74,7 @@ void CItemScheduler::Reset(bool keepPersistent)
 			it++;
 	}
 
-	if (m_timers.empty() && m_schedule.empty())
+	if (m_schedule.empty())
 		m_pItem->EnableUpdate(false, eIUS_Scheduler);
 
   SetBusy(false);
@@ -67,56 +83,115 @@ void CItemScheduler::Reset(bool keepPersistent)
 //------------------------------------------------------------------------
 void CItemScheduler::Update(float frameTime)
 {
+	// timers are run by UpdateTimers, the item only updates while actions wait for it to be idle
+	while(!m_schedule.empty() && !m_busy)
+	{
+		SScheduledAction &action = *m_schedule.begin();
+		ISchedulerAction *pAction= action.action;
+		m_schedule.erase(m_schedule.begin());
+
+		pAction->execute(m_pItem);
+		pAction->destroy();
+	}
+
+	if (m_schedule.empty())
+		m_pItem->EnableUpdate(false, eIUS_Scheduler);
+}
+
+//------------------------------------------------------------------------
+void CItemScheduler::UpdateTimers(float frameTime)
+{
+	FUNCTION_PROFILER(GetISystem(), PROFILE_GAME);
+
 	if (frameTime > 0.2f)
 		frameTime = 0.2f;
 
-	if (!m_schedule.empty())
-	{
-		while(!m_schedule.empty() && !m_busy)
-		{
-			SScheduledAction &action = *m_schedule.begin();
-			ISchedulerAction *pAction= action.action;
-			m_schedule.erase(m_schedule.begin());
+	s_time += frameTime;
 
-			pAction->execute(m_pItem);
-			pAction->destroy();
-		}
-	}
+	// wake-ups and timers armed from now on wait for the next frame, even if they are due already
+	const unsigned int sequenceEnd = s_sequence;
 
-	if (!m_timers.empty())
+	while (!s_wakeUps.empty() && s_wakeUps.front().time <= s_time && s_wakeUps.front().sequence < sequenceEnd)
 	{
-		unsigned int count=0;
-		m_actives.swap(m_timers);
+		const SWakeUp wakeUp = s_wakeUps.front();
+		std::pop_heap(s_wakeUps.begin(), s_wakeUps.end(), compare_wakeups());
+		s_wakeUps.pop_back();
 
-		for (TTimerActionVector::iterator it = m_actives.begin(); it != m_actives.end(); it++)
-		{
-			STimerAction &action = *it;
-			action.time -= frameTime;
-			if (action.time <= 0.0f)
-			{
-				action.action->execute(m_pItem);
-				action.action->destroy();
-				++count;
-			}
-		}
+		if (wakeUp.scheduler->m_wakeUpTime == wakeUp.time)
+			wakeUp.scheduler->ExecuteTimers(sequenceEnd);
+	}
+}
 
-		if (count)
-			m_actives.erase(m_actives.begin(), m_actives.begin()+count);
+//------------------------------------------------------------------------
+void CItemScheduler::ExecuteTimers(unsigned int sequenceEnd)
+{
+	m_wakeUpTime = -1.0;
 
+	// same as CItem::Update, the timers wait until the item is back
+	if (m_pItem->IsFrozen() || m_pItem->IsDestroyed())
+	{
 		if (!m_timers.empty())
-		{
-			for (TTimerActionVector::iterator it=m_timers.begin(); it!=m_timers.end(); ++it)
-				m_actives.push_back(*it);
+			WakeUp(s_time);
+		return;
+	}
 
-			std::sort(m_actives.begin(), m_actives.end(), compare_timers());
-		}
+	// take all due timers first, timers added by the actions wait for the next frame
+	while (!m_timers.empty() && m_timers.front().time <= s_time && m_timers.front().sequence < sequenceEnd)
+	{
+		std::pop_heap(m_timers.begin(), m_timers.end(), compare_timers());
+		m_actives.push_back(m_timers.back());
+		m_timers.pop_back();
+	}
 
-		m_actives.swap(m_timers);
-		m_actives.resize(0);
+	for (size_t i = 0; i < m_actives.size(); i++)
+	{
+		m_actives[i].action->execute(m_pItem);
+		m_actives[i].action->destroy();
 	}
 
-	if (m_timers.empty() && m_schedule.empty())
-		m_pItem->EnableUpdate(false, eIUS_Scheduler);
+	m_actives.resize(0);
+
+	WakeUp();
+}
+
+//------------------------------------------------------------------------
+void CItemScheduler::WakeUp()
+{
+	if (!m_timers.empty())
+		WakeUp(m_timers.front().time);
+}
+
+//------------------------------------------------------------------------
+void CItemScheduler::WakeUp(double time)
+{
+	if (m_wakeUpTime >= 0.0 && m_wakeUpTime <= time)
+		return;
+
+	SWakeUp wakeUp;
+	wakeUp.scheduler = this;
+	wakeUp.time = time;
+	wakeUp.sequence = s_sequence++;
+
+	s_wakeUps.push_back(wakeUp);
+	std::push_heap(s_wakeUps.begin(), s_wakeUps.end(), compare_wakeups());
+
+	m_wakeUpTime = time;
+}
+
+//------------------------------------------------------------------------
+void CItemScheduler::RemoveWakeUps()
+{
+	const size_t count = s_wakeUps.size();
+
+	s_wakeUps.erase(std::remove_if(s_wakeUps.begin(), s_wakeUps.end(), [this](const SWakeUp &wakeUp)
+	{
+		return wakeUp.scheduler == this;
+	}), s_wakeUps.end());
+
+	if (s_wakeUps.size() != count)
+		std::make_heap(s_wakeUps.begin(), s_wakeUps.end(), compare_wakeups());
+
+	m_wakeUpTime = -1.0;
 }
 
 //------------------------------------------------------------------------
@@ -148,13 +223,14 @@ void CItemScheduler::TimerAction(unsigned int time, ISchedulerAction *action, bo
 
 	STimerAction timerAction;
 	timerAction.action = action;
-	timerAction.time = (float)time/1000.0f;
+	timerAction.time = s_time + (double)time/1000.0;
+	timerAction.sequence = s_sequence++;
 	timerAction.persist = persistent;
 
 	m_timers.push_back(timerAction);
-	std::sort(m_timers.begin(), m_timers.end(), compare_timers());
+	std::push_heap(m_timers.begin(), m_timers.end(), compare_timers());
 
-	m_pItem->EnableUpdate(true, eIUS_Scheduler);
+	WakeUp();
 }
 
 //------------------------------------------------------------------------
@@ -190,3 +266,8 @@ void CItemScheduler::GetMemoryStatistics(ICrySizer * s)
 	for (size_t i=0; i<m_schedule.size(); i++)
 		m_schedule[i].action->GetMemoryStatistics(s);
 }
+
+void CItemScheduler::GetGlobalMemoryStatistics(ICrySizer * s)
+{
+	s->AddContainer(s_wakeUps);
+}
@@ -84,18 +84,35 @@ class CItemScheduler
 	struct STimerAction
 	{
 		ISchedulerAction	*action;
-		float							time;
+		double						time;			// absolute, on the scheduler clock
+		unsigned int			sequence;	// keeps timers due at the same time in order
 		bool							persist;
 	};
+	// one per item with pending timers, keyed by its earliest due time
+	struct SWakeUp
+	{
+		CItemScheduler		*scheduler;
+		double						time;
+		unsigned int			sequence;
+	};
 
 	typedef std::vector<STimerAction>									TTimerActionVector;
 	typedef std::vector<SScheduledAction>							TScheduledActionVector;
+	typedef std::vector<SWakeUp>											TWakeUpVector;
 
+	// min-heap predicates for std::push_heap/std::pop_heap
 	struct compare_timers
 	{
 		bool operator() (const STimerAction &lhs, const STimerAction &rhs ) const
 		{
-			return lhs.time < rhs.time;
+			return (lhs.time > rhs.time) || (lhs.time == rhs.time && lhs.sequence > rhs.sequence);
+		}
+	};
+	struct compare_wakeups
+	{
+		bool operator() (const SWakeUp &lhs, const SWakeUp &rhs ) const
+		{
+			return (lhs.time > rhs.time) || (lhs.time == rhs.time && lhs.sequence > rhs.sequence);
 		}
 	};
 
@@ -114,15 +131,29 @@ public:
 	void Lock(bool lock);
 	bool IsLocked();
 
+	// advances the shared clock and runs the due timers of all items, once per frame
+	static void UpdateTimers(float frameTime);
+	static void GetGlobalMemoryStatistics(ICrySizer * s);
+
 private:
+	void ExecuteTimers(unsigned int sequenceEnd);
+	void WakeUp();
+	void WakeUp(double time);
+	void RemoveWakeUps();
+
 	bool				m_locked;
 	bool				m_busy;
 	ITimer			*m_pTimer;
 	CItem				*m_pItem;
 
-	TTimerActionVector				m_timers;
+	TTimerActionVector				m_timers;		// min-heap
 	TTimerActionVector				m_actives;
 	TScheduledActionVector		m_schedule;
+	double										m_wakeUpTime;	// time of the live wake-up entry, negative if none
+
+	static TWakeUpVector			s_wakeUps;		// min-heap, entries not matching m_wakeUpTime are stale
+	static double							s_time;
+	static unsigned int				s_sequence;
 };
 
 
@@ -21,13 +21,8 @@ History:
 #define TRACER_GEOM_SLOT  0
 #define TRACER_FX_SLOT    1
 //------------------------------------------------------------------------
-CTracer::CTracer(const Vec3 &pos)
-: m_pos(0,0,0),
-	m_dest(0,0,0),
-	m_startingpos(pos),
-	m_age(0.0f),
-	m_lifeTime(1.5f),
-	m_entityId(0),
+CTracer::CTracer()
+: m_entityId(0),
 	m_useGeometry(false),
 	m_geometrySlot(0)
 {
@@ -43,13 +38,9 @@ CTracer::~CTracer()
 }
 
 //------------------------------------------------------------------------
-void CTracer::Reset(const Vec3 &pos)
+void CTracer::Reset()
 {
-	m_pos=Vec3(0,0,0);
-	m_dest=Vec3(0,0,0);
-	m_startingpos=pos;
-	m_age=0.0f;
-	m_lifeTime=1.5f;
+	m_useGeometry=false;
 
 	if (IEntity *pEntity=gEnv->pEntitySystem->GetEntity(m_entityId))
 	{
@@ -85,6 +76,7 @@ void CTracer::SetGeometry(const char *name, float scale)
 	if (IEntity *pEntity=gEnv->pEntitySystem->GetEntity(m_entityId))
 	{
 		m_geometrySlot =pEntity->LoadGeometry(TRACER_GEOM_SLOT, name);
+		m_useGeometry = true;
 
 		if (scale!=1.0f)
 		{
@@ -114,67 +106,6 @@ void CTracer::SetEffect(const char *name, float scale)
 	}
 }
 
-//------------------------------------------------------------------------
-bool CTracer::Update(float frameTime, const Vec3 &camera)
-{
-	if(m_age==0.0f)
-	{
-		m_age+=0.002f;
-		frameTime = 0.002f;
-	}
-	else
-		m_age += frameTime;
-
-	if (m_age >= m_lifeTime)
-		return false;
-
-	Vec3 end(m_dest);
-
-	if (((m_pos-end).len2() <= 0.25f))
-		return false;
-
-	Vec3 dp = end-m_pos;
-	float dist = dp.len();
-	Vec3 dir = dp/dist;
-
-	float scaleMult=1.0f;
-
-	float minDistance = g_pGameCVars->tracer_min_distance;
-	float maxDistance = g_pGameCVars->tracer_max_distance;
-	float minScale = g_pGameCVars->tracer_min_scale;
-	float maxScale = g_pGameCVars->tracer_max_scale;
-	float sqrRadius = g_pGameCVars->tracer_player_radiusSqr;
-
-	float cameraDistance = (m_pos-camera).len2();
-	float speed = m_speed;
-
-	//Slow down tracer when near the player
-	if(cameraDistance<=sqrRadius)
-		speed *= (0.35f + (cameraDistance/(sqrRadius*2)));
-
-	m_pos = m_pos+dir*MIN(speed*frameTime, dist);
-	
-	cameraDistance = (m_pos-camera).len2();
-
-	if (cameraDistance<=minDistance*minDistance)
-		scaleMult=minScale;
-	else if (cameraDistance>=maxDistance*maxDistance)
-		scaleMult=maxScale;
-	else
-	{
-		float t=(sqrtf(cameraDistance)-minDistance)/(maxDistance-minDistance);
-		scaleMult=minScale+t*(maxScale-minScale);
-	}
-
-	const float assetLenght = 2.0f;
-	if((m_pos-m_dest).len2()<0.25f)
-		return false;
-
-	UpdateVisual(m_pos, dir, m_useGeometry?scaleMult:1.0f, 1.0f);
-
-	return true;
-}
-
 //------------------------------------------------------------------------
 void CTracer::UpdateVisual(const Vec3 &pos, const Vec3 &dir, float scale, float length)
 {
@@ -195,14 +126,19 @@ void CTracer::UpdateVisual(const Vec3 &pos, const Vec3 &dir, float scale, float
 }
 
 //------------------------------------------------------------------------
-void CTracer::SetLifeTime(float lifeTime)
+void CTracer::Hide(bool hide)
 {
-	m_lifeTime = lifeTime;
+	if (IEntity *pEntity=gEnv->pEntitySystem->GetEntity(m_entityId))
+	{
+		pEntity->Hide(hide);
+		if (hide)
+			pEntity->SetWorldTM(Matrix34::CreateIdentity());
+	}
 }
 
 //------------------------------------------------------------------------
 CTracerManager::CTracerManager()
-: m_lastFree(0)
+: m_emitted(0)
 {
 }
 
@@ -217,69 +153,167 @@ void CTracerManager::EmitTracer(const STracerParams &params)
 	if(!g_pGameCVars->g_enableTracers || !gEnv->bClient)
 		return;
 
-	int idx=0;
-	if (m_pool.empty() && g_pGameCVars->tracer_max_count>0)
+	const int maxEmitted = g_pGameCVars->tracer_max_emit_per_frame;
+	if (maxEmitted>0 && m_emitted>=maxEmitted)
+		return;
+
+	// skip tracers that pass too far away to be seen
+	const float cullDistance = g_pGameCVars->tracer_cull_distance;
+	if (cullDistance>0.0f)
 	{
-		m_pool.push_back(new CTracer(params.position));
-		idx=m_pool.size()-1;
+		const Vec3 camera = gEnv->pSystem->GetViewCamera().GetPosition();
+		const Vec3 path = params.destination-params.position;
+		const float pathLen2 = path.len2();
+		const float t = pathLen2>0.0f ? clamp_tpl((camera-params.position).Dot(path)/pathLen2, 0.0f, 1.0f) : 0.0f;
+
+		if ((params.position+path*t-camera).len2() > cullDistance*cullDistance)
+			return;
 	}
-	else
-	{
-		int s=m_pool.size();
-		int i=m_lastFree+1;
 
-		while (true)
-		{
-			IEntity *pEntity=0;
-			if (i<(int)m_pool.size())
-				pEntity=gEnv->pEntitySystem->GetEntity(m_pool[i]->m_entityId);
-
-			if (i==s)
-				i=0;
-			else if (i==m_lastFree)
-			{
-				m_pool.push_back(new CTracer(params.position));
-				idx=m_pool.size()-1;
-				break;
-			}
-			else if (pEntity && pEntity->IsHidden())
-			{
-				m_pool[i]->Reset(params.position);
-				idx=i;
-				break;
-			}
-			else
-				++i;
-		}
+	int idx;
+	if (!m_free.empty())
+	{
+		idx=m_free.back();
+		m_free.pop_back();
+		m_pool[idx]->Reset();
 	}
+	else if ((int)m_pool.size() < g_pGameCVars->tracer_max_count)
+	{
+		m_pool.push_back(new CTracer());
+		idx=m_pool.size()-1;
+	}
+	else
+		return;
 
-	m_lastFree=idx;
+	++m_emitted;
 
 	CTracer *tracer = m_pool[idx];
 
 	if (params.geometry && params.geometry[0])
-	{
 		tracer->SetGeometry(params.geometry, 1.0f);
-		tracer->m_useGeometry = true;
-	}
 	if (params.effect && params.effect[0])
 		tracer->SetEffect(params.effect, 1.0f);
 
-	tracer->SetLifeTime(params.lifetime);
+	tracer->Hide(false);
+
+	m_actives.push_back(idx);
+	m_positions.push_back(params.position);
+	m_destinations.push_back(params.destination);
+	m_directions.push_back(Vec3(0,1,0));
+	m_speeds.push_back(params.speed);
+	m_ages.push_back(0.0f);
+	m_lifeTimes.push_back(params.lifetime);
+	m_scales.push_back(1.0f);
+	m_alive.push_back(1);
+}
 
-	tracer->m_speed = params.speed;
-	tracer->m_pos = params.position;
-	tracer->m_dest = params.destination;
+//------------------------------------------------------------------------
+void CTracerManager::Simulate(float frameTime, const Vec3 &camera)
+{
+	const float minDistance = g_pGameCVars->tracer_min_distance;
+	const float maxDistance = g_pGameCVars->tracer_max_distance;
+	const float minScale = g_pGameCVars->tracer_min_scale;
+	const float maxScale = g_pGameCVars->tracer_max_scale;
+	const float sqrRadius = g_pGameCVars->tracer_player_radiusSqr;
+
+	const int count = (int)m_actives.size();
+
+	Vec3 *positions = &m_positions[0];
+	const Vec3 *destinations = &m_destinations[0];
+	Vec3 *directions = &m_directions[0];
+	const float *speeds = &m_speeds[0];
+	float *ages = &m_ages[0];
+	const float *lifeTimes = &m_lifeTimes[0];
+	float *scales = &m_scales[0];
+	uint8 *alive = &m_alive[0];
+
+	for (int i=0; i<count; i++)
+	{
+		float dt = frameTime;
 
-	if (IEntity *pEntity=gEnv->pEntitySystem->GetEntity(tracer->m_entityId))
-		pEntity->Hide(0);
+		// the first step is tiny so that the tracer starts at the muzzle
+		if (ages[i]==0.0f)
+			dt = 0.002f;
 
-	m_actives.push_back(idx);
+		ages[i] += dt;
+
+		const Vec3 dp = destinations[i]-positions[i];
+		const float dist2 = dp.len2();
+
+		if (ages[i] >= lifeTimes[i] || dist2 <= 0.25f)
+		{
+			alive[i] = 0;
+			continue;
+		}
+
+		const float dist = sqrt_tpl(dist2);
+		const Vec3 dir = dp/dist;
+
+		//Slow down tracer when near the player
+		float speed = speeds[i];
+		float cameraDistance = (positions[i]-camera).len2();
+		if (cameraDistance<=sqrRadius)
+			speed *= (0.35f + (cameraDistance/(sqrRadius*2)));
+
+		positions[i] += dir*min(speed*dt, dist);
+		directions[i] = dir;
+
+		if ((positions[i]-destinations[i]).len2() < 0.25f)
+		{
+			alive[i] = 0;
+			continue;
+		}
+
+		cameraDistance = (positions[i]-camera).len2();
+
+		if (cameraDistance<=minDistance*minDistance)
+			scales[i]=minScale;
+		else if (cameraDistance>=maxDistance*maxDistance)
+			scales[i]=maxScale;
+		else
+		{
+			const float t=(sqrt_tpl(cameraDistance)-minDistance)/(maxDistance-minDistance);
+			scales[i]=minScale+t*(maxScale-minScale);
+		}
+	}
+}
+
+//------------------------------------------------------------------------
+void CTracerManager::RemoveActive(int index)
+{
+	const int last = (int)m_actives.size()-1;
+
+	m_free.push_back(m_actives[index]);
+
+	m_actives[index] = m_actives[last];
+	m_positions[index] = m_positions[last];
+	m_destinations[index] = m_destinations[last];
+	m_directions[index] = m_directions[last];
+	m_speeds[index] = m_speeds[last];
+	m_ages[index] = m_ages[last];
+	m_lifeTimes[index] = m_lifeTimes[last];
+	m_scales[index] = m_scales[last];
+	m_alive[index] = m_alive[last];
+
+	m_actives.pop_back();
+	m_positions.pop_back();
+	m_destinations.pop_back();
+	m_directions.pop_back();
+	m_speeds.pop_back();
+	m_ages.pop_back();
+	m_lifeTimes.pop_back();
+	m_scales.pop_back();
+	m_alive.pop_back();
 }
 
 //------------------------------------------------------------------------
 void CTracerManager::Update(float frameTime)
 {
+	m_emitted = 0;
+
+	if (m_actives.empty())
+		return;
+
 	IActor *pActor=g_pGame->GetIGameFramework()->GetClientActor();
 	if (!pActor)
 		return;
@@ -290,24 +324,21 @@ void CTracerManager::Update(float frameTime)
 	
 	pActor->GetMovementController()->GetMovementState(state);
 
-	m_actives.swap(m_updating);
-	for (TTracerIdVector::iterator it = m_updating.begin(); it!=m_updating.end(); ++it)
+	Simulate(frameTime, state.eyePosition);
+
+	// backwards, so that the swapped in last element was visited already
+	for (int i=(int)m_actives.size()-1; i>=0; i--)
 	{
-		CTracer *tracer = m_pool[*it];
+		CTracer *tracer = m_pool[m_actives[i]];
 
-		if (tracer->Update(frameTime, state.eyePosition))
-			m_actives.push_back(*it);
+		if (m_alive[i])
+			tracer->UpdateVisual(m_positions[i], m_directions[i], tracer->m_useGeometry?m_scales[i]:1.0f, 1.0f);
 		else
 		{
-			if (IEntity *pEntity=gEnv->pEntitySystem->GetEntity(tracer->m_entityId))
-			{
-				pEntity->Hide(1);
-				pEntity->SetWorldTM(Matrix34::CreateIdentity());
-			}
+			tracer->Hide(true);
+			RemoveActive(i);
 		}
 	}
-
-	m_updating.resize(0);
 }
 
 //------------------------------------------------------------------------
@@ -316,18 +347,37 @@ void CTracerManager::Reset()
 	for (TTracerPool::iterator it = m_pool.begin(); it!=m_pool.end(); ++it)
 		delete *it;
 
-	m_updating.resize(0);
-	m_actives.resize(0);
 	m_pool.resize(0);
+	m_free.resize(0);
+
+	m_actives.resize(0);
+	m_positions.resize(0);
+	m_destinations.resize(0);
+	m_directions.resize(0);
+	m_speeds.resize(0);
+	m_ages.resize(0);
+	m_lifeTimes.resize(0);
+	m_scales.resize(0);
+	m_alive.resize(0);
+
+	m_emitted = 0;
 }
 
 void CTracerManager::GetMemoryStatistics(ICrySizer * s)
 {
 	SIZER_SUBCOMPONENT_NAME(s, "TracerManager");
 	s->Add(*this);
-	s->AddContainer(m_updating);
-	s->AddContainer(m_actives);
 	s->AddContainer(m_pool);
+	s->AddContainer(m_free);
+	s->AddContainer(m_actives);
+	s->AddContainer(m_positions);
+	s->AddContainer(m_destinations);
+	s->AddContainer(m_directions);
+	s->AddContainer(m_speeds);
+	s->AddContainer(m_ages);
+	s->AddContainer(m_lifeTimes);
+	s->AddContainer(m_scales);
+	s->AddContainer(m_alive);
 
 	for (size_t i=0; i<m_pool.size(); i++)
 		m_pool[i]->GetMemoryStatistics(s);
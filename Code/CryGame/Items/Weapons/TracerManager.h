@@ -20,30 +20,23 @@ History:
 
 #include "CryCommon/CryEntitySystem/EntityId.h"
 
+// pooled tracer entity, the kinematics are kept by CTracerManager
 class CTracer
 {
 	friend class CTracerManager;
 public:
-	CTracer(const Vec3 &pos);
+	CTracer();
 	virtual ~CTracer();
 
-	void Reset(const Vec3 &pos);
+	void Reset();
 	void CreateEntity();
 	void SetGeometry(const char *name, float scale);
 	void SetEffect(const char *name, float scale);
-	void SetLifeTime(float lifeTime);
-	bool Update(float frameTime, const Vec3 &campos);
 	void UpdateVisual(const Vec3 &pos, const Vec3 &dir, float scale, float length);
-	float GetAge() const;
+	void Hide(bool hide);
 	void GetMemoryStatistics(ICrySizer * s) const;
 
 private:
-	float				m_speed;
-	Vec3				m_pos;
-	Vec3				m_dest;
-	Vec3				m_startingpos;
-	float				m_age;
-	float				m_lifeTime;
 	bool        m_useGeometry;
 	int         m_geometrySlot;
 
@@ -55,6 +48,8 @@ class CTracerManager
 {
 	typedef std::vector<CTracer *>	TTracerPool;
 	typedef std::vector<int>				TTracerIdVector;
+	typedef std::vector<Vec3>				TVec3Vector;
+	typedef std::vector<float>			TFloatVector;
 public:
 	CTracerManager();
 	virtual ~CTracerManager();
@@ -75,10 +70,25 @@ public:
 	void GetMemoryStatistics(ICrySizer *);
 
 private:
-	TTracerPool			m_pool;
-	TTracerIdVector m_updating;
+	// advances all active tracers in one pass, clears m_alive of the finished ones
+	void Simulate(float frameTime, const Vec3 &camera);
+	void RemoveActive(int index);
+
+	TTracerPool			m_pool;				// at most tracer_max_count entities, created on demand
+	TTracerIdVector	m_free;
+
+	// active tracers as parallel arrays, m_actives holds their pool indices
 	TTracerIdVector	m_actives;
-	int							m_lastFree;
+	TVec3Vector			m_positions;
+	TVec3Vector			m_destinations;
+	TVec3Vector			m_directions;
+	TFloatVector		m_speeds;
+	TFloatVector		m_ages;
+	TFloatVector		m_lifeTimes;
+	TFloatVector		m_scales;
+	std::vector<uint8>	m_alive;
+
+	int							m_emitted;		// this frame, limited by tracer_max_emit_per_frame
 };
 
 
@@ -10,6 +10,8 @@ History:
 - 18:10:2005   18:00 : Created by Márcio Martins
 
 *************************************************************************/
+#include <algorithm>
+
 #include "CryCommon/CrySystem/ISystem.h"
 #include "CryCommon/CrySystem/IConsole.h"
 #include "CryGame/Game.h"
@@ -47,6 +49,7 @@ History:
 #include "FireModes/Scan.h"
 #include "FireModes/SingleTG.h"
 #include "../ItemSharedParams.h"
+#include "../ItemScheduler.h"
 
 
 #include "ZoomModes/IronSight.h"
@@ -81,7 +84,10 @@ CWeaponSystem::CWeaponSystem(CGame *pGame, ISystem *pSystem)
 	m_recursing(false),
 	m_frozenEnvironment(false),
 	m_wetEnvironment(false),
-	m_tokensUpdated(false)
+	m_tokensUpdated(false),
+	m_sortedProjectiles(0),
+	m_projectileMaxSpeed(0.0f),
+	m_projectileUpdateTime(0.0f)
 {
 	// register fire modes here
 	RegisterFireMode("Single", &CreateIt<CSingle, IFireMode>);
@@ -127,9 +133,12 @@ CWeaponSystem::CWeaponSystem(CGame *pGame, ISystem *pSystem)
 //------------------------------------------------------------------------
 CWeaponSystem::~CWeaponSystem()
 {
-	// cleanup current projectiles
-	for (TProjectileMap::iterator pit = m_projectiles.begin(); pit != m_projectiles.end(); ++pit)
-		gEnv->pEntitySystem->RemoveEntity(pit->first, true);
+	// cleanup current projectiles, RemoveProjectile only marks their entries
+	for (size_t i = 0; i < m_projectiles.size(); i++)
+	{
+		if (m_projectiles[i].pProjectile)
+			gEnv->pEntitySystem->RemoveEntity(m_projectiles[i].entityId, true);
+	}
 
 	for (TAmmoTypeParams::iterator it = m_ammoparams.begin(); it != m_ammoparams.end(); ++it)
 	{
@@ -149,8 +158,62 @@ CWeaponSystem::~CWeaponSystem()
 //------------------------------------------------------------------------
 void CWeaponSystem::Update(float frameTime)
 {
+	CItemScheduler::UpdateTimers(frameTime);
 	m_tracerManager.Update(frameTime);
 	CheckEnvironmentChanges();
+	UpdateProjectiles();
+}
+
+//------------------------------------------------------------------------
+void CWeaponSystem::UpdateProjectiles()
+{
+	FUNCTION_PROFILER(GetISystem(), PROFILE_GAME);
+
+	const float frameTime = gEnv->pTimer->GetFrameTime();
+	float maxSpeed = 0.0f;
+	size_t count = 0;
+
+	// drop removed entries and take the current positions in one pass
+	for (size_t i = 0; i < m_projectiles.size(); i++)
+	{
+		SProjectileEntry &entry = m_projectiles[i];
+		if (!entry.pProjectile)
+			continue;
+
+		const Vec3 pos = entry.pEntity->GetWorldPos();
+
+		// the physics velocity also covers projectiles that were not sorted before
+		float speed = 0.0f;
+		pe_status_dynamics dyn;
+		if (IPhysicalEntity *pPhysics = entry.pEntity->GetPhysics())
+		{
+			if (pPhysics->GetStatus(&dyn))
+				speed = dyn.v.len();
+		}
+
+		// projectiles moved without physics, added ones were not positioned yet when added
+		if (i < m_sortedProjectiles && frameTime > 0.0f)
+			speed = max(speed, (pos - entry.pos).len() / frameTime);
+
+		maxSpeed = max(maxSpeed, speed);
+
+		entry.pos = pos;
+		m_projectiles[count++] = entry;
+	}
+
+	m_projectiles.resize(count);
+
+	std::sort(m_projectiles.begin(), m_projectiles.end(), [](const SProjectileEntry &a, const SProjectileEntry &b)
+	{
+		return a.pos.x < b.pos.x;
+	});
+
+	for (size_t i = 0; i < count; i++)
+		m_projectileIndices[m_projectiles[i].entityId] = static_cast<uint32>(i);
+
+	m_sortedProjectiles = count;
+	m_projectileMaxSpeed = maxSpeed;
+	m_projectileUpdateTime = gEnv->pTimer->GetCurrTime();
 }
 
 //------------------------------------------------------------------------
@@ -164,16 +227,15 @@ void CWeaponSystem::Reload()
 {
 	m_reloading = true;
 
-	// cleanup current projectiles
-	for (TProjectileMap::iterator pit = m_projectiles.begin(); pit != m_projectiles.end();)
+	// cleanup current projectiles, RemoveProjectile only marks their entries
+	for (size_t i = 0; i < m_projectiles.size(); i++)
 	{
-		//Bugfix: RemoveEntity removes projectile from map, thus invalidating iterator
-		TProjectileMap::iterator next = pit;        
-		next++;
-		gEnv->pEntitySystem->RemoveEntity(pit->first, true);
-		pit = next;
+		if (m_projectiles[i].pProjectile)
+			gEnv->pEntitySystem->RemoveEntity(m_projectiles[i].entityId, true);
 	}
 	m_projectiles.clear();
+	m_projectileIndices.clear();
+	m_sortedProjectiles = 0;
 
 	for (TAmmoTypeParams::iterator it = m_ammoparams.begin(); it != m_ammoparams.end(); ++it)
 	{
@@ -371,54 +433,93 @@ const SAmmoParams* CWeaponSystem::GetAmmoParams(IEntityClass* pAmmoType) const
 //------------------------------------------------------------------------
 void CWeaponSystem::AddProjectile(IEntity *pEntity, CProjectile *pProjectile)
 {
-	m_projectiles.insert(TProjectileMap::value_type(pEntity->GetId(), pProjectile));
+	const EntityId entityId = pEntity->GetId();
+
+	if (m_projectileIndices.find(entityId) != m_projectileIndices.end())
+		return;
+
+	SProjectileEntry entry;
+	entry.entityId = entityId;
+	entry.pProjectile = pProjectile;
+	entry.pEntity = pEntity;
+	entry.pClass = pEntity->GetClass();
+	entry.pos = pEntity->GetWorldPos();
+
+	m_projectileIndices[entityId] = static_cast<uint32>(m_projectiles.size());
+	m_projectiles.push_back(entry);
 }
 
 //------------------------------------------------------------------------
 void CWeaponSystem::RemoveProjectile(CProjectile *pProjectile)
 {
-	m_projectiles.erase(pProjectile->GetEntity()->GetId());
+	TProjectileIndexMap::iterator it = m_projectileIndices.find(pProjectile->GetEntity()->GetId());
+	if (it == m_projectileIndices.end())
+		return;
+
+	// the order is kept until the next Update, queries skip the entry
+	m_projectiles[it->second].pProjectile = 0;
+	m_projectileIndices.erase(it);
 }
 
 //------------------------------------------------------------------------
 CProjectile *CWeaponSystem::GetProjectile(EntityId entityId)
 {
-	TProjectileMap::iterator it = m_projectiles.find(entityId);
-	if (it != m_projectiles.end())
-		return it->second;
+	TProjectileIndexMap::iterator it = m_projectileIndices.find(entityId);
+	if (it != m_projectileIndices.end())
+		return m_projectiles[it->second].pProjectile;
 	return 0;
 }
 
 //------------------------------------------------------------------------
 int  CWeaponSystem::QueryProjectiles(SProjectileQuery& q)
 {
-    IEntityClass* pClass = q.ammoName?gEnv->pEntitySystem->GetClassRegistry()->FindClass(q.ammoName):0;
-    m_queryResults.resize(0);
-    if(q.box.IsEmpty())
-    {
-        for(TProjectileMap::iterator it = m_projectiles.begin();it!=m_projectiles.end();++it)
-        {
-            IEntity *pEntity = it->second->GetEntity();
-            if(pClass == 0 || pEntity->GetClass() == pClass)
-            m_queryResults.push_back(pEntity);
-        }
-    }
-    else
-    {
-        for(TProjectileMap::iterator it = m_projectiles.begin();it!=m_projectiles.end();++it)
-        {
-            IEntity *pEntity = it->second->GetEntity();
-            if(q.box.IsContainPoint(pEntity->GetWorldPos()))
-            {
-                m_queryResults.push_back(pEntity);
-            }
-        }
-    }
-    
-    q.nCount = int(m_queryResults.size());
-    if(q.nCount)
-        q.pResults = &m_queryResults[0];
-    return q.nCount;
+	FUNCTION_PROFILER(GetISystem(), PROFILE_GAME);
+
+	IEntityClass* pClass = q.ammoName?gEnv->pEntitySystem->GetClassRegistry()->FindClass(q.ammoName):0;
+	m_queryResults.resize(0);
+
+	const bool anywhere = q.box.IsEmpty();
+
+	TProjectileVector::const_iterator sortedBegin = m_projectiles.begin();
+	TProjectileVector::const_iterator sortedEnd = m_projectiles.begin() + m_sortedProjectiles;
+
+	if (!anywhere)
+	{
+		// the sorted positions are from the last Update, the box test below uses the current ones
+		// the elapsed time grows with long frames, one more frame covers a physics step taken before the query
+		const float elapsed = max(gEnv->pTimer->GetCurrTime() - m_projectileUpdateTime, 0.0f) + gEnv->pTimer->GetFrameTime();
+		const float margin = m_projectileMaxSpeed * elapsed;
+		const float minX = q.box.min.x - margin;
+		const float maxX = q.box.max.x + margin;
+
+		sortedBegin = std::lower_bound(sortedBegin, sortedEnd, minX, [](const SProjectileEntry &entry, float x) { return entry.pos.x < x; });
+		sortedEnd = std::upper_bound(sortedBegin, sortedEnd, maxX, [](float x, const SProjectileEntry &entry) { return x < entry.pos.x; });
+	}
+
+	auto addResult = [&](const SProjectileEntry &entry)
+	{
+		if (!entry.pProjectile)
+			return;
+
+		if (pClass && entry.pClass != pClass)
+			return;
+
+		if (!anywhere && !q.box.IsContainPoint(entry.pEntity->GetWorldPos()))
+			return;
+
+		m_queryResults.push_back(entry.pEntity);
+	};
+
+	for (TProjectileVector::const_iterator it = sortedBegin; it != sortedEnd; ++it)
+		addResult(*it);
+
+	for (size_t i = m_sortedProjectiles; i < m_projectiles.size(); i++)
+		addResult(m_projectiles[i]);
+
+	q.nCount = int(m_queryResults.size());
+	if(q.nCount)
+		q.pResults = &m_queryResults[0];
+	return q.nCount;
 }
 
 //------------------------------------------------------------------------
@@ -720,6 +821,7 @@ void CWeaponSystem::GetMemoryStatistics(ICrySizer * s)
 	s->AddObject(this,nSize);
 
 	m_tracerManager.GetMemoryStatistics(s);
+	CItemScheduler::GetGlobalMemoryStatistics(s);
 	s->AddContainer(m_fmregistry);
 	s->AddContainer(m_zmregistry);
 	s->AddContainer(m_projectileregistry);
@@ -746,10 +848,12 @@ void CWeaponSystem::GetMemoryStatistics(ICrySizer * s)
 	
 	{
 		SIZER_SUBCOMPONENT_NAME(s, "Projectiles");
-		int nSize = m_projectiles.size() * sizeof(TProjectileMap::value_type);
-		for (TProjectileMap::iterator iter = m_projectiles.begin(); iter != m_projectiles.end(); ++iter)
+		int nSize = m_projectiles.capacity() * sizeof(TProjectileVector::value_type);
+		nSize += m_projectileIndices.size() * sizeof(TProjectileIndexMap::value_type);
+		for (TProjectileVector::iterator iter = m_projectiles.begin(); iter != m_projectiles.end(); ++iter)
 		{
-			nSize += iter->second->GetMemorySize();
+			if (iter->pProjectile)
+				nSize += iter->pProjectile->GetMemorySize();
 		}
 		s->AddObject(&m_projectiles,nSize);
 	}
@@ -28,6 +28,8 @@ History:
 #include "CryCommon/CryCore/VectorMap.h"
 #include "AmmoParams.h"
 
+#include <unordered_map>
+
 class CGame;
 class CProjectile;
 struct ISystem;
@@ -58,11 +60,22 @@ class CWeaponSystem : public ILevelSystemListener
 	typedef std::map<string, IFireMode		*(*)()>								TFireModeRegistry;
 	typedef std::map<string, IZoomMode		*(*)()>								TZoomModeRegistry;
 	typedef std::map<string, IGameObjectExtensionCreatorBase *>	TProjectileRegistry;
-	typedef std::map<EntityId, CProjectile *>										TProjectileMap;
+	typedef std::unordered_map<EntityId, uint32>								TProjectileIndexMap;
 	typedef VectorMap<IEntityClass*, SAmmoTypeDesc>							TAmmoTypeParams;
 	typedef std::vector<string>																	TFolderList;
 	typedef std::vector<IEntity*>																TIEntityVector;
 
+	struct SProjectileEntry
+	{
+		EntityId			entityId;
+		CProjectile		*pProjectile;	// null once removed, dropped by the next Update
+		IEntity				*pEntity;
+		IEntityClass	*pClass;
+		Vec3					pos;					// world position at the last Update
+	};
+
+	typedef std::vector<SProjectileEntry>												TProjectileVector;
+
 public:
 	CWeaponSystem(CGame *pGame, ISystem *pSystem);
 	virtual ~CWeaponSystem();
@@ -117,6 +130,8 @@ public:
 	void ApplyEnvironmentChanges();
 	void CheckEnvironmentChanges();
 
+	void UpdateProjectiles();
+
 	void Serialize(TSerialize ser);
 
 	//CryMP
@@ -141,7 +156,13 @@ private:
 	TZoomModeRegistry		m_zmregistry;
 	TProjectileRegistry	m_projectileregistry;
 	TAmmoTypeParams			m_ammoparams;
-	TProjectileMap			m_projectiles;
+	// sorted by x at the last Update so that box queries only look at a slice of it
+	// projectiles added since then are appended after m_sortedProjectiles entries
+	TProjectileVector		m_projectiles;
+	TProjectileIndexMap	m_projectileIndices;
+	size_t							m_sortedProjectiles;
+	float								m_projectileMaxSpeed;			// fastest projectile at the last Update
+	float								m_projectileUpdateTime;		// when the positions were taken
 
 	TFolderList					m_folders;
 	bool								m_reloading;
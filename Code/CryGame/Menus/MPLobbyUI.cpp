@@ -317,6 +317,7 @@ struct SMPServerList
 			m_allServers[idx] = srv;
 
 			m_allServers[idx].m_ping = ping;
+			m_dirty = true;
 		}
 	}
 
@@ -338,9 +339,31 @@ struct SMPServerList
 			RemoveFromVisible(idx);
 			stl::find_and_erase(m_favorites, idx);
 			stl::find_and_erase(m_recent, idx);
+
+			// the following servers moved down by one
+			ShiftIndices(m_all, idx);
+			ShiftIndices(m_favorites, idx);
+			ShiftIndices(m_recent, idx);
+
+			if (m_selectedServer == idx)
+				m_selectedServer = -1;
+			else if (m_selectedServer > idx)
+				m_selectedServer--;
+
+			if (m_startIndex + m_visibleCount > m_all.size())
+				m_startIndex = max(int(m_all.size()) - m_visibleCount, 0);
+
+			m_dirty = true;
 		}
 	}
 
+	static void ShiftIndices(DisplayedServersVector& indices, int removedIdx)
+	{
+		for (int& i : indices)
+			if (i > removedIdx)
+				i--;
+	}
+
 	int GetServerIdxById(int id)
 	{
 		for (uint32 i = 0;i < m_allServers.size();i++)
@@ -1044,7 +1044,9 @@ void    CMultiPlayerMenu::UpdateServerList()
 	switch (m_ui->GetCurTab())
 	{
 	case 0:
-		m_ui->ClearServerList();
+		// the CryMP browser keeps its servers and reports only what changed
+		if (m_browser != gClient->GetServerBrowser())
+			m_ui->ClearServerList();
 		m_ui->StartUpdate();
 		m_ui->SetUpdateProgress(0, -1);
 		m_browser->Update();
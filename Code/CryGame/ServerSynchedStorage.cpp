@@ -53,20 +53,16 @@ void CServerSynchedStorage::ResetChannel(int channelId)
 {
 	std::lock_guard lock(m_mutex);
 
-	auto git = m_globalQueue.lower_bound(SChannelQueueEnt(channelId, 0));
-	while (git != m_globalQueue.end() && git->first.channel == channelId)
+	SChannel *pChannel = GetChannel(channelId);
+	if (!pChannel)
 	{
-		git = m_globalQueue.erase(git);
+		return;
 	}
 
-	auto eit = m_entityQueue.lower_bound(SChannelEntityQueueEnt(channelId, 0, 0));
-	while (eit != m_entityQueue.end() && eit->first.channel == channelId)
-	{
-		eit = m_entityQueue.erase(eit);
-	}
+	ClearDirty(*pChannel);
+	pChannel->messageHandles.clear();
 
-	SChannel *pChannel = GetChannel(channelId);
-	if (pChannel && pChannel->pNetChannel)
+	if (pChannel->pNetChannel)
 	{
 		auto *pMsg = new CClientSynchedStorage::CResetMsg(channelId, this);
 
@@ -74,116 +70,153 @@ void CServerSynchedStorage::ResetChannel(int channelId)
 	}
 }
 
+void CServerSynchedStorage::Dump()
+{
+	std::lock_guard lock(m_mutex);
+
+	CSynchedStorage::Dump();
+
+	CryLogAlways("---------------------------\n");
+	CryLogAlways("Replication: %llu changes, %llu messages sent, %llu messages coalesced (~%llu bytes)",
+		m_stats.changes, m_stats.sentMessages, m_stats.coalescedMessages, m_stats.coalescedBytes);
+}
+
 void CServerSynchedStorage::DefineProtocol(IProtocolBuilder *pBuilder)
 {
 	pBuilder->AddMessageSink(this, CClientSynchedStorage::GetProtocolDef(), CServerSynchedStorage::GetProtocolDef());
 }
 
-void CServerSynchedStorage::AddToGlobalQueue(TSynchedKey key)
+void CServerSynchedStorage::MarkDirty(SChannel & channel, uint32 index)
 {
-	for (const auto & item : m_channels)
+	const size_t word = index / 64;
+	const uint64 bit = 1ULL << (index % 64);
+
+	if (word >= channel.dirtyBits.size())
 	{
-		if (!item.second.local)
-		{
-			AddToGlobalQueueFor(item.first, key);
-		}
+		channel.dirtyBits.resize(word + 1);
 	}
-}
 
-void CServerSynchedStorage::AddToEntityQueue(EntityId entityId, TSynchedKey key)
-{
-	for (const auto & item : m_channels)
+	if (channel.dirtyBits[word] & bit)
 	{
-		if (!item.second.local)
+		const SValue & value = m_values[index];
+
+		// key, entity id and the value itself
+		size_t size = sizeof (TSynchedKey) + (value.isGlobal ? 0 : sizeof (EntityId));
+
+		switch (value.value.GetType())
 		{
-			AddToEntityQueueFor(item.first, entityId, key);
+			case eSVT_Bool:     size += 1;                                    break;
+			case eSVT_Float:    size += sizeof (float);                       break;
+			case eSVT_Int:      size += sizeof (int);                         break;
+			case eSVT_EntityId: size += sizeof (EntityId);                    break;
+			case eSVT_String:   size += value.value.GetPtr<string>()->size(); break;
 		}
+
+		m_stats.coalescedMessages++;
+		m_stats.coalescedBytes += size;
+
+		return;
 	}
+
+	channel.dirtyBits[word] |= bit;
+	channel.dirtyValues.push_back(index);
 }
 
-void CServerSynchedStorage::AddToGlobalQueueFor(int channelId, TSynchedKey key)
+void CServerSynchedStorage::ClearDirty(SChannel & channel)
 {
-	SChannel *pChannel = GetChannel(channelId);
-	if (!pChannel || !pChannel->pNetChannel || pChannel->local)
+	for (uint32 index : channel.dirtyValues)
 	{
-		return;
+		channel.dirtyBits[index / 64] &= ~(1ULL << (index % 64));
 	}
 
-	SSendableHandle & msgHandle = m_globalQueue[SChannelQueueEnt(channelId, key)];
+	channel.dirtyValues.clear();
+}
 
-	TSynchedValue value;
-	if (!GetGlobalValue(key, value))
-	{
-		return;
-	}
+void CServerSynchedStorage::SendValue(int channelId, SChannel & channel, uint32 index)
+{
+	SValue & value = m_values[index];
+	SSendableHandle & msgHandle = channel.messageHandles[index];
 
-	CClientSynchedStorage::CSetGlobalMsg *pMsg = nullptr;
+	INetMessage *pMsg = nullptr;
 
-	switch (value.GetType())
+	if (value.isGlobal)
 	{
-		case eSVT_Bool:
-			pMsg = new CClientSynchedStorage::CSetGlobalBoolMsg(channelId, this, key, value);
-			break;
-		case eSVT_Float:
-			pMsg = new CClientSynchedStorage::CSetGlobalFloatMsg(channelId, this, key, value);
-			break;
-		case eSVT_Int:
-			pMsg = new CClientSynchedStorage::CSetGlobalIntMsg(channelId, this, key, value);
-			break;
-		case eSVT_EntityId:
-			pMsg = new CClientSynchedStorage::CSetGlobalEntityIdMsg(channelId, this, key, value);
-			break;
-		case eSVT_String:
-			pMsg = new CClientSynchedStorage::CSetGlobalStringMsg(channelId, this, key, value);
-			break;
+		switch (value.value.GetType())
+		{
+			case eSVT_Bool:
+				pMsg = new CClientSynchedStorage::CSetGlobalBoolMsg(channelId, this, value.key, value.value);
+				break;
+			case eSVT_Float:
+				pMsg = new CClientSynchedStorage::CSetGlobalFloatMsg(channelId, this, value.key, value.value);
+				break;
+			case eSVT_Int:
+				pMsg = new CClientSynchedStorage::CSetGlobalIntMsg(channelId, this, value.key, value.value);
+				break;
+			case eSVT_EntityId:
+				pMsg = new CClientSynchedStorage::CSetGlobalEntityIdMsg(channelId, this, value.key, value.value);
+				break;
+			case eSVT_String:
+				pMsg = new CClientSynchedStorage::CSetGlobalStringMsg(channelId, this, value.key, value.value);
+				break;
+		}
+	}
+	else
+	{
+		switch (value.value.GetType())
+		{
+			case eSVT_Bool:
+				pMsg = new CClientSynchedStorage::CSetEntityBoolMsg(channelId, this, value.entityId, value.key, value.value);
+				break;
+			case eSVT_Float:
+				pMsg = new CClientSynchedStorage::CSetEntityFloatMsg(channelId, this, value.entityId, value.key, value.value);
+				break;
+			case eSVT_Int:
+				pMsg = new CClientSynchedStorage::CSetEntityIntMsg(channelId, this, value.entityId, value.key, value.value);
+				break;
+			case eSVT_EntityId:
+				pMsg = new CClientSynchedStorage::CSetEntityEntityIdMsg(channelId, this, value.entityId, value.key, value.value);
+				break;
+			case eSVT_String:
+				pMsg = new CClientSynchedStorage::CSetEntityStringMsg(channelId, this, value.entityId, value.key, value.value);
+				break;
+		}
 	}
 
 	if (pMsg)
 	{
-		pChannel->pNetChannel->SubstituteSendable(pMsg, 1, &pChannel->lastOrderedMessage, &msgHandle);
+		channel.pNetChannel->SubstituteSendable(pMsg, 1, &channel.lastOrderedMessage, &msgHandle);
+
+		m_stats.sentMessages++;
 	}
 }
 
-void CServerSynchedStorage::AddToEntityQueueFor(int channelId, EntityId entityId, TSynchedKey key)
+void CServerSynchedStorage::Flush()
 {
-	SChannel *pChannel = GetChannel(channelId);
-	if (!pChannel || !pChannel->pNetChannel || pChannel->local)
-	{
-		return;
-	}
+	FUNCTION_PROFILER(GetISystem(), PROFILE_GAME);
 
-	SSendableHandle & msgHandle = m_entityQueue[SChannelEntityQueueEnt(channelId, entityId, key)];
+	std::lock_guard lock(m_mutex);
 
-	TSynchedValue value;
-	if (!GetEntityValue(entityId, key, value))
+	for (auto & [channelId, channel] : m_channels)
 	{
-		return;
-	}
-
-	CClientSynchedStorage::CSetEntityMsg *pMsg = nullptr;
+		if (channel.dirtyValues.empty())
+		{
+			continue;
+		}
 
-	switch (value.GetType())
-	{
-		case eSVT_Bool:
-			pMsg = new CClientSynchedStorage::CSetEntityBoolMsg(channelId, this, entityId, key, value);
-			break;
-		case eSVT_Float:
-			pMsg = new CClientSynchedStorage::CSetEntityFloatMsg(channelId, this, entityId, key, value);
-			break;
-		case eSVT_Int:
-			pMsg = new CClientSynchedStorage::CSetEntityIntMsg(channelId, this, entityId, key, value);
-			break;
-		case eSVT_EntityId:
-			pMsg = new CClientSynchedStorage::CSetEntityEntityIdMsg(channelId, this, entityId, key, value);
-			break;
-		case eSVT_String:
-			pMsg = new CClientSynchedStorage::CSetEntityStringMsg(channelId, this, entityId, key, value);
-			break;
-	}
+		if (channel.pNetChannel && !channel.local)
+		{
+			if (channel.messageHandles.size() < m_values.size())
+			{
+				channel.messageHandles.resize(m_values.size());
+			}
+
+			for (uint32 index : channel.dirtyValues)
+			{
+				SendValue(channelId, channel, index);
+			}
+		}
 
-	if (pMsg)
-	{
-		pChannel->pNetChannel->SubstituteSendable(pMsg, 1, &pChannel->lastOrderedMessage, &msgHandle);
+		ClearDirty(channel);
 	}
 }
 
@@ -197,28 +230,31 @@ void CServerSynchedStorage::FullSynch(int channelId, bool reset)
 		ResetChannel(channelId);
 	}
 
-	for (const auto & item : m_globalStorage)
+	SChannel *pChannel = GetChannel(channelId);
+	if (!pChannel || !pChannel->pNetChannel || pChannel->local)
 	{
-		AddToGlobalQueueFor(channelId, item.first);
+		return;
 	}
 
-	for (const auto & entityItem : m_entityStorage)
+	const uint32 count = static_cast<uint32>(m_values.size());
+
+	for (uint32 index = 0; index < count; index++)
 	{
-		for (const auto & item : entityItem.second)
-		{
-			AddToEntityQueueFor(channelId, entityItem.first, item.first);
-		}
+		MarkDirty(*pChannel, index);
 	}
 }
 
-void CServerSynchedStorage::OnGlobalChanged(TSynchedKey key, const TSynchedValue & value)
+void CServerSynchedStorage::OnValueChanged(uint32 index)
 {
-	AddToGlobalQueue(key);
-}
+	m_stats.changes++;
 
-void CServerSynchedStorage::OnEntityChanged(EntityId entityId, TSynchedKey key, const TSynchedValue & value)
-{
-	AddToEntityQueue(entityId, key);
+	for (auto & [channelId, channel] : m_channels)
+	{
+		if (channel.pNetChannel && !channel.local)
+		{
+			MarkDirty(channel, index);
+		}
+	}
 }
 
 void CServerSynchedStorage::OnClientConnect(int channelId)
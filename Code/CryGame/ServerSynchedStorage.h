@@ -1,5 +1,7 @@
 #pragma once
 
+#include <map>
+
 #include "ClientSynchedStorage.h"
 
 class CServerSynchedStorage : public CNetMessageSinkHelper<CServerSynchedStorage, CSynchedStorage>
@@ -11,6 +13,11 @@ class CServerSynchedStorage : public CNetMessageSinkHelper<CServerSynchedStorage
 		bool local = false;
 		bool onhold = false;
 
+		// changed values waiting for the next flush, indexed like m_values
+		std::vector<uint64> dirtyBits;
+		std::vector<uint32> dirtyValues;
+		std::vector<SSendableHandle> messageHandles;
+
 		SChannel() = default;
 
 		SChannel(INetChannel *pNetChannel, bool isLocal)
@@ -21,76 +28,26 @@ class CServerSynchedStorage : public CNetMessageSinkHelper<CServerSynchedStorage
 		}
 	};
 
-	struct SChannelQueueEnt
-	{
-		int channel = 0;
-		TSynchedKey key = 0;
-
-		SChannelQueueEnt() = default;
-
-		SChannelQueueEnt(int channel, TSynchedKey key)
-		: channel(channel),
-		  key(key)
-		{
-		}
-
-		bool operator<(const SChannelQueueEnt & rhs) const
-		{
-			return rhs.channel < channel || (rhs.channel == channel && rhs.key < key);
-		}
-	};
-
-	struct SChannelEntityQueueEnt
+	struct SStats
 	{
-		int channel = 0;
-		EntityId entity = 0;
-		TSynchedKey key = 0;
-
-		SChannelEntityQueueEnt() = default;
-
-		SChannelEntityQueueEnt(int channel, EntityId entity, TSynchedKey key)
-		: channel(channel),
-		  entity(entity),
-		  key(key)
-		{
-		}
-
-		bool operator<(const SChannelEntityQueueEnt& rhs) const
-		{
-			if (channel < rhs.channel)
-				return true;
-			else if (channel > rhs.channel)
-				return false;
-			else if (key < rhs.key)
-				return true;
-			else if (key > rhs.key)
-				return false;
-			else if (entity < rhs.entity)
-				return true;
-			else if (entity > rhs.entity)
-				return false;
-			else
-				return false;
-		}
+		uint64 changes = 0;
+		uint64 sentMessages = 0;
+		uint64 coalescedMessages = 0;  // changes replaced by a newer one before the flush
+		uint64 coalescedBytes = 0;     // approximate payload size of the coalesced messages
 	};
 
-	using TChannelQueueMap = std::map<SChannelQueueEnt, SSendableHandle>;
-	using TChannelEntityQueueMap = std::map<SChannelEntityQueueEnt, SSendableHandle>;
 	using TChannelMap = std::map<int, SChannel>;
 
-	TChannelQueueMap m_globalQueue;
-	TChannelEntityQueueMap m_entityQueue;
 	TChannelMap m_channels;
+	SStats m_stats;
 
 	SChannel *GetChannel(int channelId);
 	SChannel *GetChannel(INetChannel *pNetChannel);
 	int GetChannelId(INetChannel *pNetChannel);
 
-	void AddToGlobalQueue(TSynchedKey key);
-	void AddToEntityQueue(EntityId entityId, TSynchedKey key);
-
-	void AddToGlobalQueueFor(int channelId, TSynchedKey key);
-	void AddToEntityQueueFor(int channelId, EntityId entityId, TSynchedKey key);
+	void MarkDirty(SChannel & channel, uint32 index);
+	void ClearDirty(SChannel & channel);
+	void SendValue(int channelId, SChannel & channel, uint32 index);
 
 public:
 	CServerSynchedStorage(IGameFramework *pGameFramework)
@@ -103,13 +60,17 @@ public:
 	void Reset() override;
 	void ResetChannel(int channelId);
 
+	void Dump() override;
+
 	void FullSynch(int channelId, bool reset);
 
+	// main thread, sends the values changed since the last flush, one message per value and channel
+	void Flush();
+
 	void OnClientConnect(int channelId);
 	void OnClientDisconnect(int channelId, bool onhold);
 	void OnClientEnteredGame(int channelId);
 
 protected:
-	void OnGlobalChanged(TSynchedKey key, const TSynchedValue & value) override;
-	void OnEntityChanged(EntityId entityId, TSynchedKey key, const TSynchedValue & value) override;
+	void OnValueChanged(uint32 index) override;
 };
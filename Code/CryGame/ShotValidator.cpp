@@ -15,6 +15,13 @@ History:
 #include "GameRules.h"
 
 
+//------------------------------------------------------------------------
+CShotValidator::TChannel::TChannel()
+{
+	for (int16 &slot : shotIndex)
+		slot = -1;
+}
+
 //------------------------------------------------------------------------
 CShotValidator::CShotValidator(CGameRules *pGameRules, IItemSystem *pItemSystem, IGameFramework *pGameFramework)
 : m_pGameRules(pGameRules)
@@ -41,34 +48,42 @@ void CShotValidator::AddShot(EntityId playerId, EntityId weaponId, uint16 seq, u
 	int channelId=m_pGameRules->GetChannelId(playerId);
 	int shotLife=3;
 
-	TShot shot(seq, weaponId, now, shotLife);
+	TChannel *pChannel=GetChannel(channelId);
+	assert(pChannel);
+	if (!pChannel)
+		return;
 
-	TChannelHits::iterator chit=m_pendinghits.find(channelId);
-	assert(chit!=m_pendinghits.end());
-	THits &hits=chit->second;
-	THits::iterator hit=hits.find(shot);
+	TShot shot;
+	shot.weaponId=weaponId;
+	shot.seq=seq;
+	shot.life=shotLife;
+	shot.time=now;
 
-	while (shot.life>0 && hit!=hits.end() && shot==hit->first)
+	const uint64 key=GetKey(weaponId, seq);
+
+	// pending hits are released in the order they arrived
+	for (int i=0; shot.life>0 && i<pChannel->hitCount; i++)
 	{
-		//CryLogAlways("found a matching hit! seq: %d  id: %d  age: %.2f  size: %d", shot.seq, shot.weaponId, (now-hit->second.time).GetMilliSeconds(), hits.size());
+		THit &hit=pChannel->hits[(pChannel->hitHead+i)&(HIT_CAPACITY-1)];
+		if (hit.key!=key)
+			continue;
+
+		//CryLogAlways("found a matching hit! seq: %d  id: %d  age: %.2f  size: %d", shot.seq, shot.weaponId, (now-hit.time).GetMilliSeconds(), pChannel->hitCount);
 
-		HitInfo info=hit->second.info;
-		hits.erase(hit);
+		HitInfo info=hit.info;
+		hit.key=0;
 
 		m_doingHit=true;
 		m_pGameRules->ServerHit(info);
 		m_doingHit=false;
-		
+
 		--shot.life;
-		hit=hits.find(shot);
 	}
 
-	if (shot.life>0)
+	// a shot that is already known keeps its remaining life
+	if (shot.life>0 && FindShot(*pChannel, key)<0)
 	{
-		TChannelShots::iterator csit=m_shots.find(channelId);
-		assert(csit!=m_shots.end());
-		TShots &shots=csit->second;
-		shots.insert(shot);
+		InsertShot(*pChannel, shot);
 
 		//CryLogAlways("added shot! seq: %d  id: %d", shot.seq, shot.weaponId);
 	}
@@ -97,42 +112,34 @@ bool CShotValidator::ProcessHit(const HitInfo &hitInfo)
 	CTimeValue now=gEnv->pTimer->GetFrameStartTime();
 	int channelId=m_pGameRules->GetChannelId(hitInfo.shooterId);
 
-	TShot shot(hitInfo.seq, hitInfo.weaponId, now, 0);
-	
-	TChannelShots::iterator csit=m_shots.find(channelId);
-	if (csit!=m_shots.end())
-	{
-		TShots &shots=csit->second;
-		TShots::iterator found=shots.find(shot);
-
-		if (found!=shots.end())
-		{
-			//CryLogAlways("found a matching shot! seq: %d  id: %d  age: %.2f  size: %d", shot.seq, shot.weaponId, (now-found->time).GetMilliSeconds(), shots.size());
+	TChannel *pChannel=GetChannel(channelId);
+	assert(pChannel);
+	if (!pChannel)
+		return false;
 
-			TShot &fshot=const_cast<TShot&>(*found);
+	const int indexPos=FindShot(*pChannel, GetKey(hitInfo.weaponId, hitInfo.seq));
+	if (indexPos>=0)
+	{
+		TShot &shot=pChannel->shots[pChannel->shotIndex[indexPos]];
 
-			if (fshot.life>0)
-				--fshot.life;
-		//	else
-		//		CryLogAlways("invalid shot consumption! seq: %d  id: %d", fshot.seq, fshot.weaponId);
+		//CryLogAlways("found a matching shot! seq: %d  id: %d  age: %.2f  size: %d", shot.seq, shot.weaponId, (now-shot.time).GetMilliSeconds(), pChannel->shotCount);
 
-			if (Expired(now, fshot))
-			{
-				//CryLogAlways("expired shot found! seq: %d  id: %d  age: %.2f", fshot.seq, fshot.weaponId, (now-fshot.time).GetMilliSeconds());
+		if (shot.life>0)
+			--shot.life;
 
-				shots.erase(found);
-			}
+		if (Expired(now, shot))
+		{
+			//CryLogAlways("expired shot found! seq: %d  id: %d  age: %.2f", shot.seq, shot.weaponId, (now-shot.time).GetMilliSeconds());
 
-			return true;
+			RemoveShot(*pChannel, indexPos);
 		}
+
+		return true;
 	}
 
-	TChannelHits::iterator chit=m_pendinghits.find(channelId);
-	assert(chit!=m_pendinghits.end());
-	THits &hits=chit->second;
-	hits.insert(THits::value_type(shot, THit(hitInfo, now)));
+	AddPendingHit(*pChannel, hitInfo, now);
 
-	//CryLogAlways("hit pending! seq: %d  id: %d  age: %.2f  size: %d", shot.seq, shot.weaponId, 0.0f, hits.size());
+	//CryLogAlways("hit pending! seq: %d  id: %d  age: %.2f  size: %d", hitInfo.seq, hitInfo.weaponId, 0.0f, pChannel->hitCount);
 
 	return false;
 }
@@ -140,34 +147,30 @@ bool CShotValidator::ProcessHit(const HitInfo &hitInfo)
 //------------------------------------------------------------------------
 void CShotValidator::Connected(int channelId)
 {
-	Disconnected(channelId); // make sure it's cleaned up
-
-	m_shots.insert(TChannelShots::value_type(channelId, TShots()));
-	m_pendinghits.insert(TChannelHits::value_type(channelId, THits()));
+	// preallocated here so that shots and hits never allocate
+	m_channels[channelId]=std::make_unique<TChannel>();
 }
 
 //------------------------------------------------------------------------
 void CShotValidator::Disconnected(int channelId)
 {
-	m_shots.erase(channelId);
-	m_pendinghits.erase(channelId);
+	m_channels.erase(channelId);
 }
 
 //------------------------------------------------------------------------
 void CShotValidator::Reset()
 {
-	TChannelShots::iterator csend=m_shots.end();
-	for (TChannelShots::iterator csit=m_shots.begin(); csit!=csend; ++csit)
+	for (TChannels::value_type &channel : m_channels)
 	{
-		TShots &shots=csit->second;
-		shots.clear();
-	}
+		TChannel &ch=*channel.second;
 
-	TChannelHits::iterator chend=m_pendinghits.end();
-	for (TChannelHits::iterator chit=m_pendinghits.begin(); chit!=chend; ++chit)
-	{
-		THits &hits=chit->second;
-		hits.clear();
+		ch.shotHead=0;
+		ch.shotCount=0;
+		for (int16 &slot : ch.shotIndex)
+			slot=-1;
+
+		ch.hitHead=0;
+		ch.hitCount=0;
 	}
 }
 
@@ -178,46 +181,135 @@ void CShotValidator::Update()
 
 	CTimeValue now=gEnv->pTimer->GetFrameStartTime();
 
-	TChannelShots::iterator csend=m_shots.end();
-	for (TChannelShots::iterator csit=m_shots.begin(); csit!=csend; ++csit)
+	for (TChannels::value_type &channel : m_channels)
 	{
-		TShots &shots=csit->second;
+		TChannel &ch=*channel.second;
 
-		for (TShots::iterator shot=shots.begin(); shot!=shots.end();)
+		while (ch.shotCount>0)
 		{
-			if (!Expired(now, *shot))
-			{
-				++shot;
-				continue;
-			}
+			const TShot &shot=ch.shots[ch.shotHead];
+			if (!Expired(now, shot))
+				break;
 
-			//CryLogAlways("expired shot found! seq: %d  id: %d  age: %.2f", shot->seq, shot->weaponId, (now-shot->time).GetMilliSeconds());
+			//CryLogAlways("expired shot found! seq: %d  id: %d  age: %.2f", shot.seq, shot.weaponId, (now-shot.time).GetMilliSeconds());
 
-			TShots::iterator erasing=shot++;
-			shots.erase(erasing);
+			PopShot(ch);
+		}
+
+		while (ch.hitCount>0)
+		{
+			const THit &hit=ch.hits[ch.hitHead];
+			if (hit.key && !Expired(now, hit))
+				break;
+
+			// CryLogAlways("aged hit found! seq: %d  id: %d  age: %.2f", hit.info.seq, hit.info.weaponId, (now-hit.time).GetMilliSeconds());
+
+			PopPendingHit(ch);
 		}
 	}
+}
 
-	TChannelHits::iterator chend=m_pendinghits.end();
-	for (TChannelHits::iterator chit=m_pendinghits.begin(); chit!=chend; ++chit)
+//------------------------------------------------------------------------
+CShotValidator::TChannel *CShotValidator::GetChannel(int channelId)
+{
+	TChannels::iterator it=m_channels.find(channelId);
+	return (it!=m_channels.end()) ? it->second.get() : NULL;
+}
+
+//------------------------------------------------------------------------
+int CShotValidator::FindShot(const TChannel &channel, uint64 key) const
+{
+	for (uint32 i=GetIndexHome(key); ; i=(i+1)&(SHOT_INDEX_SIZE-1))
 	{
-		THits &hits=chit->second;
-		for (THits::iterator hit=hits.begin(); hit!=hits.end();)
-		{
-			if (!Expired(now, hit->second))
-			{
-				++hit;
-				continue;
-			}
+		const int slot=channel.shotIndex[i];
+		if (slot<0)
+			return -1;
 
-			DeclareExpired(chit->first, hit->second.info);
+		const TShot &shot=channel.shots[slot];
+		if (GetKey(shot.weaponId, shot.seq)==key)
+			return i;
+	}
+}
 
-			// CryLogAlways("aged hit found! seq: %d  id: %d  age: %.2f", hit->second.info.seq, hit->second.info.weaponId, (now-hit->second.time).GetMilliSeconds());
+//------------------------------------------------------------------------
+void CShotValidator::InsertShot(TChannel &channel, const TShot &shot)
+{
+	// the oldest shot is dropped rather than growing
+	if (channel.shotCount==SHOT_CAPACITY)
+		PopShot(channel);
+
+	const int slot=(channel.shotHead+channel.shotCount)&(SHOT_CAPACITY-1);
+	channel.shots[slot]=shot;
+	++channel.shotCount;
+
+	uint32 i=GetIndexHome(GetKey(shot.weaponId, shot.seq));
+	while (channel.shotIndex[i]>=0)
+		i=(i+1)&(SHOT_INDEX_SIZE-1);
+
+	channel.shotIndex[i]=static_cast<int16>(slot);
+}
+
+//------------------------------------------------------------------------
+void CShotValidator::RemoveShot(TChannel &channel, int indexPos)
+{
+	const uint32 mask=SHOT_INDEX_SIZE-1;
 
-			THits::iterator erasing=hit++;
-			hits.erase(erasing);
+	channel.shots[channel.shotIndex[indexPos]].life=0;
+
+	// backward shift deletion keeps the probe sequences intact without tombstones
+	uint32 hole=indexPos;
+	for (uint32 i=(hole+1)&mask; channel.shotIndex[i]>=0; i=(i+1)&mask)
+	{
+		const TShot &shot=channel.shots[channel.shotIndex[i]];
+		const uint32 home=GetIndexHome(GetKey(shot.weaponId, shot.seq));
+
+		if (((i-home)&mask)>=((i-hole)&mask))
+		{
+			channel.shotIndex[hole]=channel.shotIndex[i];
+			hole=i;
 		}
 	}
+
+	channel.shotIndex[hole]=-1;
+}
+
+//------------------------------------------------------------------------
+void CShotValidator::PopShot(TChannel &channel)
+{
+	const TShot &shot=channel.shots[channel.shotHead];
+	if (shot.life>0)
+	{
+		const int indexPos=FindShot(channel, GetKey(shot.weaponId, shot.seq));
+		if (indexPos>=0)
+			RemoveShot(channel, indexPos);
+	}
+
+	channel.shotHead=(channel.shotHead+1)&(SHOT_CAPACITY-1);
+	--channel.shotCount;
+}
+
+//------------------------------------------------------------------------
+void CShotValidator::AddPendingHit(TChannel &channel, const HitInfo &hitInfo, const CTimeValue &now)
+{
+	if (channel.hitCount==HIT_CAPACITY)
+		PopPendingHit(channel);
+
+	THit &hit=channel.hits[(channel.hitHead+channel.hitCount)&(HIT_CAPACITY-1)];
+	hit.key=GetKey(hitInfo.weaponId, hitInfo.seq);
+	hit.time=now;
+	hit.info=hitInfo;
+	++channel.hitCount;
+}
+
+//------------------------------------------------------------------------
+void CShotValidator::PopPendingHit(TChannel &channel)
+{
+	const THit &hit=channel.hits[channel.hitHead];
+	if (hit.key)
+		DeclareExpired(channel, hit.info);
+
+	channel.hitHead=(channel.hitHead+1)&(HIT_CAPACITY-1);
+	--channel.hitCount;
 }
 
 //------------------------------------------------------------------------
@@ -252,14 +344,7 @@ bool CShotValidator::Expired(const CTimeValue &now, const THit &hit) const
 }
 
 //------------------------------------------------------------------------
-void CShotValidator::DeclareExpired(int channelId, const HitInfo &hit)
+void CShotValidator::DeclareExpired(TChannel &channel, const HitInfo &hit)
 {
-	TChannelExpiredHits::iterator it=m_expired.find(channelId);
-	if (it==m_expired.end())
-	{
-		std::pair<TChannelExpiredHits::iterator, bool> ir=m_expired.insert(TChannelExpiredHits::value_type(channelId, 0));
-		it=ir.first;
-	}
-
-	++it->second;
+	++channel.expiredHits;
 }
@@ -19,6 +19,9 @@ History:
 #endif
 
 
+#include <memory>
+#include <unordered_map>
+
 #include "CryCommon/CryAction/IGameRulesSystem.h"
 
 
@@ -26,43 +29,48 @@ class CGameRules;
 
 class CShotValidator
 {
-	struct TShot
+	enum
 	{
-		TShot(uint16 seqn, EntityId wpnId, CTimeValue t, uint8 lives): seq(seqn), weaponId(wpnId), time(t), life(lives) {};
-		bool ILINE operator==(const TShot &that) const {
-			return seq==that.seq && weaponId==that.weaponId;
-		};
-		bool ILINE operator!=(const TShot &that) const {
-			return !(*this == that);
-		};
-		bool ILINE operator<(const TShot &that) const {
-			return weaponId<that.weaponId || (weaponId==that.weaponId && seq<that.seq);
-		};
+		SHOT_CAPACITY = 512,      // per channel, power of two
+		SHOT_INDEX_BITS = 10,     // twice the shot capacity keeps the index at most half full
+		SHOT_INDEX_SIZE = 1 << SHOT_INDEX_BITS,
+		HIT_CAPACITY = 128,       // per channel, power of two
+	};
 
-		uint16			seq;
+	struct TShot
+	{
 		EntityId		weaponId;
-		
+		uint16			seq;
+		uint8				life;   // 0 if consumed, the shot is not in the index anymore
 		CTimeValue	time;
-		uint8				life;
-
 	};
 
 	struct THit
 	{
-		THit(const HitInfo &hit, CTimeValue t): info(hit), time(t) {};
-
+		uint64			key;    // 0 if matched or expired
 		CTimeValue	time;
 		HitInfo			info;
-
 	};
 
-	typedef std::set<TShot>																TShots;
-	typedef std::multimap<TShot, THit, std::less<TShot> >	THits;
+	// shots and pending hits are kept in preallocated rings in arrival order
+	// the oldest entries are at the head, so expiry never looks past the first entry that is not due
+	struct TChannel
+	{
+		TChannel();
+
+		TShot				shots[SHOT_CAPACITY];
+		int					shotHead = 0;
+		int					shotCount = 0;
+		int16				shotIndex[SHOT_INDEX_SIZE];  // ring slots of live shots by weapon id and sequence number, -1 if empty
 
-	typedef std::map<int, TShots>													TChannelShots;
-	typedef std::map<int, THits>													TChannelHits;
+		THit				hits[HIT_CAPACITY];
+		int					hitHead = 0;
+		int					hitCount = 0;
 
-	typedef std::map<int, uint16>													TChannelExpiredHits;
+		uint16			expiredHits = 0;
+	};
+
+	typedef std::unordered_map<int, std::unique_ptr<TChannel>>	TChannels;
 
 public:
 	CShotValidator(CGameRules *pGameRules, IItemSystem *pItemSystem, IGameFramework *pGameFramework);
@@ -74,24 +82,38 @@ public:
 	void Reset();
 	void Update();
 
+	// a pending hit matched its shot and is being passed to CGameRules::ServerHit
+	bool IsReleasingHit() const { return m_doingHit; }
+
 	void Connected(int channelId);
 	void Disconnected(int channelId);
 
 private:
+	static uint64 GetKey(EntityId weaponId, uint16 seq) { return (uint64(weaponId) << 16) | seq; }
+	static uint32 GetIndexHome(uint64 key) { return uint32((key * 0x9E3779B97F4A7C15ULL) >> (64 - SHOT_INDEX_BITS)); }
+
+	TChannel *GetChannel(int channelId);
+
+	int FindShot(const TChannel &channel, uint64 key) const;
+	void InsertShot(TChannel &channel, const TShot &shot);
+	void RemoveShot(TChannel &channel, int indexPos);
+	void PopShot(TChannel &channel);
+
+	void AddPendingHit(TChannel &channel, const HitInfo &hit, const CTimeValue &now);
+	void PopPendingHit(TChannel &channel);
+
 	bool CanHit(const HitInfo &hit) const;
 	bool Expired(const CTimeValue &now, const TShot &shot) const;
 	bool Expired(const CTimeValue &now, const THit &hit) const;
 
-	void DeclareExpired(int channelId, const HitInfo &hit);
+	void DeclareExpired(TChannel &channel, const HitInfo &hit);
 
 	CGameRules					*m_pGameRules;
 	IItemSystem					*m_pItemSystem;
 	IGameFramework			*m_pGameFramework;
 
-	TChannelShots				m_shots;
-	TChannelHits				m_pendinghits;
+	TChannels						m_channels;
 	bool								m_doingHit;
-	TChannelExpiredHits	m_expired;
 };
 
 
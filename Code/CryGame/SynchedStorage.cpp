@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "CryCommon/CrySystem/ISystem.h"
 #include "CryCommon/CryEntitySystem/IEntitySystem.h"
 
@@ -44,37 +46,64 @@ void CSynchedStorage::Reset()
 {
 	std::lock_guard lock(m_mutex);
 
-	m_globalStorage.clear();
-	m_entityStorage.clear();
+	m_values.clear();
+	m_valueIndices.clear();
 }
 
 void CSynchedStorage::Dump()
 {
 	std::lock_guard lock(m_mutex);
 
+	// globals first, then entity values grouped by entity
+	std::vector<const SValue*> values;
+	values.reserve(m_values.size());
+
+	for (const SValue & value : m_values)
+	{
+		values.push_back(&value);
+	}
+
+	std::sort(values.begin(), values.end(), [](const SValue *a, const SValue *b)
+	{
+		if (a->isGlobal != b->isGlobal)
+			return a->isGlobal;
+		else if (a->entityId != b->entityId)
+			return a->entityId < b->entityId;
+		else
+			return a->key < b->key;
+	});
+
 	CryLogAlways("---------------------------");
 	CryLogAlways(" SYNCHED STORAGE DUMP");
 	CryLogAlways("---------------------------\n");
 	CryLogAlways("Globals:");
 
-	for (const auto & item : m_globalStorage)
+	auto it = values.begin();
+
+	for (; it != values.end() && (*it)->isGlobal; ++it)
 	{
-		DumpValue(item.first, item.second);
+		DumpValue((*it)->key, (*it)->value);
 	}
 
 	CryLogAlways("---------------------------\n");
 
-	for (const auto & entityItem : m_entityStorage)
-	{
-		IEntity *pEntity = gEnv->pEntitySystem->GetEntity(entityItem.first);
-		const char *name = pEntity ? pEntity->GetName() : "null";
+	const SValue *pLastValue = nullptr;
 
-		CryLogAlways("Entity %.08d(%s)", entityItem.first, name);
+	for (; it != values.end(); ++it)
+	{
+		const SValue *pValue = *it;
 
-		for (const auto & item : entityItem.second)
+		if (!pLastValue || pLastValue->entityId != pValue->entityId)
 		{
-			DumpValue(item.first, item.second);
+			IEntity *pEntity = gEnv->pEntitySystem->GetEntity(pValue->entityId);
+			const char *name = pEntity ? pEntity->GetName() : "null";
+
+			CryLogAlways("Entity %.08d(%s)", pValue->entityId, name);
 		}
+
+		DumpValue(pValue->key, pValue->value);
+
+		pLastValue = pValue;
 	}
 }
 
@@ -1,7 +1,8 @@
 #pragma once
 
-#include <map>
 #include <mutex>
+#include <unordered_map>
+#include <vector>
 
 #include "CryCommon/CryNetwork/INetwork.h"
 #include "CryCommon/CryAction/IGameFramework.h"
@@ -25,13 +26,20 @@ using TSynchedValue = CConfigurableVariant<TSynchedValueTypes, sizeof (void*)>;
 class CSynchedStorage : public INetMessageSink
 {
 public:
-	using TStorage = std::map<TSynchedKey, TSynchedValue>;
+	struct SValue
+	{
+		EntityId entityId = 0;
+		TSynchedKey key = 0;
+		bool isGlobal = false;
+		TSynchedValue value;
+	};
 
-	using TEntityStorageMap = std::map<EntityId, TStorage>;
+	using TValues = std::vector<SValue>;
 
 protected:
-	TStorage m_globalStorage;
-	TEntityStorageMap m_entityStorage;
+	// values are never removed until the next reset, so their indices are stable and can be used by the replication
+	TValues m_values;
+	std::unordered_map<uint64, uint32> m_valueIndices;
 
 	IGameFramework *m_pGameFramework = nullptr;
 
@@ -39,73 +47,66 @@ protected:
 
 	CSynchedStorage() = default;
 
-public:
-	virtual ~CSynchedStorage() = default;
-
-	template<typename ValueType>
-	void SetGlobalValue(TSynchedKey key, const ValueType & value)
+	static uint64 GetValueId(EntityId entityId, TSynchedKey key, bool isGlobal)
 	{
-		std::lock_guard lock(m_mutex);
+		return (static_cast<uint64>(isGlobal) << 48) | (static_cast<uint64>(entityId) << 16) | key;
+	}
 
-		auto it = m_globalStorage.find(key);
-		if (it == m_globalStorage.end())
+	const SValue *FindValue(EntityId entityId, TSynchedKey key, bool isGlobal) const
+	{
+		auto it = m_valueIndices.find(GetValueId(entityId, key, isGlobal));
+		if (it == m_valueIndices.end())
 		{
-			TSynchedValue & newValue = m_globalStorage[key];
-			newValue.Set(value);
-
-			OnGlobalChanged(key, newValue);
+			return nullptr;
 		}
-		else
-		{
-			const ValueType *pStoredValue = it->second.GetPtr<ValueType>();
-			if (!pStoredValue || *pStoredValue != value)
-			{
-				it->second.Set(value);
 
-				OnGlobalChanged(key, it->second);
-			}
-		}
+		return &m_values[it->second];
 	}
 
 	template<typename ValueType>
-	void SetEntityValue(EntityId id, TSynchedKey key, const ValueType & value)
+	void SetValue(EntityId entityId, TSynchedKey key, bool isGlobal, const ValueType & value)
 	{
 		std::lock_guard lock(m_mutex);
 
-		TStorage & storage = m_entityStorage[id];
+		const uint32 newIndex = static_cast<uint32>(m_values.size());
 
-		auto it = storage.find(key);
-		if (it == storage.end())
+		auto [it, isNew] = m_valueIndices.try_emplace(GetValueId(entityId, key, isGlobal), newIndex);
+		if (isNew)
 		{
-			TSynchedValue & newValue = storage[key];
-			newValue.Set(value);
+			SValue & newValue = m_values.emplace_back();
+			newValue.entityId = entityId;
+			newValue.key = key;
+			newValue.isGlobal = isGlobal;
+			newValue.value.Set(value);
 
-			OnEntityChanged(id, key, newValue);
+			OnValueChanged(newIndex);
 		}
 		else
 		{
-			const ValueType *pStoredValue = it->second.GetPtr<ValueType>();
+			SValue & storedValue = m_values[it->second];
+
+			const ValueType *pStoredValue = storedValue.value.GetPtr<ValueType>();
 			if (!pStoredValue || *pStoredValue != value)
 			{
-				it->second.Set(value);
+				storedValue.value.Set(value);
 
-				OnEntityChanged(id, key, it->second);
+				OnValueChanged(it->second);
 			}
 		}
 	}
 
 	template<typename ValueType>
-	bool GetGlobalValue(TSynchedKey key, ValueType & value)
+	bool GetValue(EntityId entityId, TSynchedKey key, bool isGlobal, ValueType & value)
 	{
 		std::lock_guard lock(m_mutex);
 
-		auto it = m_globalStorage.find(key);
-		if (it == m_globalStorage.end())
+		const SValue *pValue = FindValue(entityId, key, isGlobal);
+		if (!pValue)
 		{
 			return false;
 		}
 
-		const ValueType *pStoredValue = it->second.GetPtr<ValueType>();
+		const ValueType *pStoredValue = pValue->value.GetPtr<ValueType>();
 		if (!pStoredValue)
 		{
 			return false;
@@ -116,100 +117,69 @@ public:
 		return true;
 	}
 
-	bool GetGlobalValue(TSynchedKey key, TSynchedValue & value)
+	bool GetValue(EntityId entityId, TSynchedKey key, bool isGlobal, TSynchedValue & value)
 	{
 		std::lock_guard lock(m_mutex);
 
-		auto it = m_globalStorage.find(key);
-		if (it == m_globalStorage.end())
+		const SValue *pValue = FindValue(entityId, key, isGlobal);
+		if (!pValue)
 		{
 			return false;
 		}
 
-		value = it->second;
+		value = pValue->value;
 
 		return true;
 	}
 
-	template<typename ValueType>
-	bool GetEntityValue(EntityId entityId, TSynchedKey key, ValueType & value)
+	int GetValueType(EntityId entityId, TSynchedKey key, bool isGlobal)
 	{
 		std::lock_guard lock(m_mutex);
 
-		auto eit = m_entityStorage.find(entityId);
-		if (eit == m_entityStorage.end())
-		{
-			return false;
-		}
-
-		auto it = eit->second.find(key);
-		if (it == eit->second.end())
+		const SValue *pValue = FindValue(entityId, key, isGlobal);
+		if (!pValue)
 		{
-			return false;
+			return eSVT_None;
 		}
 
-		const ValueType *pStoredValue = it->second.GetPtr<ValueType>();
-		if (!pStoredValue)
-		{
-			return false;
-		}
+		return pValue->value.GetType();
+	}
 
-		value = *pStoredValue;
+public:
+	virtual ~CSynchedStorage() = default;
 
-		return true;
+	template<typename ValueType>
+	void SetGlobalValue(TSynchedKey key, const ValueType & value)
+	{
+		SetValue(0, key, true, value);
 	}
 
-	bool GetEntityValue(EntityId entityId, TSynchedKey key, TSynchedValue & value)
+	template<typename ValueType>
+	void SetEntityValue(EntityId id, TSynchedKey key, const ValueType & value)
 	{
-		std::lock_guard lock(m_mutex);
-
-		auto eit = m_entityStorage.find(entityId);
-		if (eit == m_entityStorage.end())
-		{
-			return false;
-		}
-
-		auto it = eit->second.find(key);
-		if (it == eit->second.end())
-		{
-			return false;
-		}
+		SetValue(id, key, false, value);
+	}
 
-		value = it->second;
+	template<typename ValueType>
+	bool GetGlobalValue(TSynchedKey key, ValueType & value)
+	{
+		return GetValue(0, key, true, value);
+	}
 
-		return true;
+	template<typename ValueType>
+	bool GetEntityValue(EntityId entityId, TSynchedKey key, ValueType & value)
+	{
+		return GetValue(entityId, key, false, value);
 	}
 
 	int GetGlobalValueType(TSynchedKey key)
 	{
-		std::lock_guard lock(m_mutex);
-
-		auto it = m_globalStorage.find(key);
-		if (it == m_globalStorage.end())
-		{
-			return eSVT_None;
-		}
-
-		return it->second.GetType();
+		return GetValueType(0, key, true);
 	}
 
 	int GetEntityValueType(EntityId id, TSynchedKey key)
 	{
-		std::lock_guard lock(m_mutex);
-
-		auto eit = m_entityStorage.find(id);
-		if (eit == m_entityStorage.end())
-		{
-			return eSVT_None;
-		}
-
-		auto it = eit->second.find(key);
-		if (it == eit->second.end())
-		{
-			return eSVT_None;
-		}
-
-		return it->second.GetType();
+		return GetValueType(id, key, false);
 	}
 
 	virtual void Reset();
@@ -220,11 +190,8 @@ public:
 	void SerializeEntityValue(TSerialize ser, EntityId id, TSynchedKey & key, TSynchedValue & value, int type);
 
 protected:
-	virtual void OnGlobalChanged(TSynchedKey key, const TSynchedValue & value)
-	{
-	}
-
-	virtual void OnEntityChanged(EntityId id, TSynchedKey key, const TSynchedValue & value)
+	// index into m_values
+	virtual void OnValueChanged(uint32 index)
 	{
 	}
 };
@@ -30,6 +30,8 @@
 #include "ParticleManager.h"
 #include "FlashFileHooks.h"
 #include "DrawTools.h"
+#include "EntityIndex.h"
+#include "TickScheduler.h"
 #include "FFontHooks.h"
 
 #include "config.h"
@@ -216,6 +218,8 @@ void Client::Init(IGameFramework *pGameFramework)
 	m_pParticleManager   = std::make_unique<ParticleManager>();
 	m_pFlashFileHooks    = std::make_unique<FlashFileHooks>();
 	m_pDrawTools         = std::make_unique<DrawTools>();
+	m_pEntityIndex       = std::make_unique<EntityIndex>();
+	m_pTickScheduler     = std::make_unique<TickScheduler>();
 
 	// prepare Lua scripts
 	m_scriptMain         = WinAPI::GetDataResource(nullptr, RESOURCE_SCRIPT_MAIN);
@@ -303,6 +307,15 @@ void Client::UpdateLoop()
 
 	while (GameWindow::GetInstance().OnUpdate() && m_pGame->Update(haveFocus, updateFlags))
 	{
+		// a hosted multiplayer server runs in this loop, its ticks are paced here
+		if (gEnv->bServer && gEnv->bMultiplayer)
+		{
+			m_pTickScheduler->Wait();
+		}
+		else
+		{
+			m_pTickScheduler->Stop();
+		}
 	}
 
 	GameWindow::GetInstance().OnQuit();
@@ -411,6 +424,7 @@ void Client::OnPostUpdate(float deltaTime)
 	m_pExecutor->OnUpdate();
 	m_pScriptCallbacks->OnUpdate(deltaTime);
 	m_pDrawTools->OnUpdate();
+	m_pParticleManager->OnTick();
 }
 
 void Client::OnSaveGame(ISaveGame *pSaveGame)
@@ -539,12 +553,17 @@ void Client::OnSpawn(IEntity *pEntity, SEntitySpawnParams & params)
 	FUNCTION_PROFILER(gEnv->pSystem, PROFILE_GAME);
 
 	m_pScriptCallbacks->OnSpawn(pEntity);
+	m_pEntityIndex->OnSpawn(pEntity);
+	m_pParticleManager->OnSpawn(pEntity);
 
 	m_lastSpawnId = pEntity->GetId();
 }
 
 bool Client::OnRemove(IEntity *pEntity)
 {
+	m_pEntityIndex->OnRemove(pEntity);
+	m_pParticleManager->OnRemove(pEntity);
+
 	return true;
 }
 
@@ -28,6 +28,8 @@ class EngineCache;
 class ParticleManager;
 class FlashFileHooks;
 class DrawTools;
+class EntityIndex;
+class TickScheduler;
 
 class Client : public IGameFrameworkListener, public ILevelSystemListener, public IEntitySystemSink
 {
@@ -56,6 +58,8 @@ class Client : public IGameFrameworkListener, public ILevelSystemListener, publi
 	std::unique_ptr<ParticleManager> m_pParticleManager;
 	std::unique_ptr<FlashFileHooks> m_pFlashFileHooks;
 	std::unique_ptr<DrawTools> m_pDrawTools;
+	std::unique_ptr<EntityIndex> m_pEntityIndex;
+	std::unique_ptr<TickScheduler> m_pTickScheduler;
 
 	std::string m_hwid;
 	std::string m_locale;
@@ -205,6 +209,16 @@ public:
 		return m_pDrawTools.get();
 	}
 
+	EntityIndex* GetEntityIndex()
+	{
+		return m_pEntityIndex.get();
+	}
+
+	TickScheduler* GetTickScheduler()
+	{
+		return m_pTickScheduler.get();
+	}
+
 	const std::vector<std::string> & GetMasters() const
 	{
 		return m_masters;
@@ -0,0 +1,257 @@
+#include <math.h>
+
+#include "CryCommon/CrySystem/ISystem.h"
+
+#include "EntityIndex.h"
+
+int EntityIndex::ToCellCoord(float value)
+{
+	return static_cast<int>(floorf(value / CELL_SIZE));
+}
+
+uint64_t EntityIndex::ToCellKey(int x, int y, int z)
+{
+	// 21 bits per axis is plenty for any level
+	return (static_cast<uint64_t>(x & 0x1FFFFF) << 42)
+	     | (static_cast<uint64_t>(y & 0x1FFFFF) << 21)
+	     | (static_cast<uint64_t>(z & 0x1FFFFF));
+}
+
+uint64_t EntityIndex::ToCellKey(const Vec3 & pos)
+{
+	return ToCellKey(ToCellCoord(pos.x), ToCellCoord(pos.y), ToCellCoord(pos.z));
+}
+
+void EntityIndex::AddToBucket(Bucket & bucket, EntityId id, size_t & pos)
+{
+	pos = bucket.size();
+	bucket.push_back(id);
+}
+
+void EntityIndex::RemoveFromBucket(Bucket & bucket, size_t pos, bool isCell)
+{
+	// swap with the last one to keep removal O(1)
+	const EntityId lastId = bucket.back();
+	bucket[pos] = lastId;
+	bucket.pop_back();
+
+	if (pos < bucket.size())
+	{
+		Entry & moved = m_entities[lastId];
+
+		if (isCell)
+			moved.cellPos = pos;
+		else
+			moved.classPos = pos;
+	}
+}
+
+void EntityIndex::AddCandidates(const Bucket & bucket, const Vec3 & center, float radius, IEntityClass *pClass,
+                                std::vector<IEntity*> & result)
+{
+	IEntitySystem *pEntitySystem = gEnv->pEntitySystem;
+
+	for (EntityId id : bucket)
+	{
+		IEntity *pEntity = pEntitySystem->GetEntity(id);
+
+		if (!pEntity || (pClass && pEntity->GetClass() != pClass))
+		{
+			continue;
+		}
+
+		if ((pEntity->GetWorldPos() - center).len2() <= radius * radius)
+		{
+			result.push_back(pEntity);
+		}
+	}
+}
+
+EntityIndex::EntityIndex()
+{
+	// entities spawned before the sink was registered
+	IEntityItPtr pIt = gEnv->pEntitySystem->GetEntityIterator();
+
+	while (IEntity *pEntity = pIt->Next())
+	{
+		OnSpawn(pEntity);
+	}
+}
+
+EntityIndex::~EntityIndex()
+{
+}
+
+void EntityIndex::OnSpawn(IEntity *pEntity)
+{
+	const EntityId id = pEntity->GetId();
+
+	if (m_entities.count(id))
+	{
+		// the ID has been reused without removal, e.g. after the entity system reset
+		OnRemove(pEntity);
+	}
+
+	Entry & entry = m_entities[id];
+	entry.pClass = pEntity->GetClass();
+	entry.cell = ToCellKey(pEntity->GetWorldPos());
+
+	AddToBucket(m_classes[entry.pClass], id, entry.classPos);
+	AddToBucket(m_cells[entry.cell], id, entry.cellPos);
+
+	gEnv->pEntitySystem->AddEntityEventListener(id, ENTITY_EVENT_XFORM, this);
+}
+
+void EntityIndex::OnRemove(IEntity *pEntity)
+{
+	const auto it = m_entities.find(pEntity->GetId());
+	if (it == m_entities.end())
+	{
+		return;
+	}
+
+	const Entry entry = it->second;
+
+	m_entities.erase(it);
+
+	gEnv->pEntitySystem->RemoveEntityEventListener(pEntity->GetId(), ENTITY_EVENT_XFORM, this);
+
+	const auto classIt = m_classes.find(entry.pClass);
+	RemoveFromBucket(classIt->second, entry.classPos, false);
+
+	const auto cellIt = m_cells.find(entry.cell);
+	RemoveFromBucket(cellIt->second, entry.cellPos, true);
+
+	if (cellIt->second.empty())
+	{
+		m_cells.erase(cellIt);
+	}
+}
+
+void EntityIndex::OnMove(IEntity *pEntity)
+{
+	const EntityId id = pEntity->GetId();
+
+	const auto it = m_entities.find(id);
+	if (it == m_entities.end())
+	{
+		return;
+	}
+
+	const uint64_t cell = ToCellKey(pEntity->GetWorldPos());
+
+	if (it->second.cell == cell)
+	{
+		return;
+	}
+
+	const auto cellIt = m_cells.find(it->second.cell);
+	RemoveFromBucket(cellIt->second, it->second.cellPos, true);
+
+	if (cellIt->second.empty())
+	{
+		m_cells.erase(cellIt);
+	}
+
+	// the entry is still valid, removal from the bucket changes only other entries
+	Entry & entry = it->second;
+	entry.cell = cell;
+
+	AddToBucket(m_cells[cell], id, entry.cellPos);
+}
+
+void EntityIndex::OnEntityEvent(IEntity *pEntity, SEntityEvent & event)
+{
+	if (event.event == ENTITY_EVENT_XFORM)
+	{
+		OnMove(pEntity);
+	}
+}
+
+void EntityIndex::GetEntitiesByClass(IEntityClass *pClass, std::vector<IEntity*> & result)
+{
+	result.clear();
+
+	const auto it = m_classes.find(pClass);
+	if (it == m_classes.end())
+	{
+		return;
+	}
+
+	IEntitySystem *pEntitySystem = gEnv->pEntitySystem;
+
+	for (EntityId id : it->second)
+	{
+		IEntity *pEntity = pEntitySystem->GetEntity(id);
+
+		if (pEntity && pEntity->GetClass() == pClass)
+		{
+			result.push_back(pEntity);
+		}
+	}
+}
+
+void EntityIndex::GetEntitiesInSphere(const Vec3 & center, float radius, IEntityClass *pClass,
+                                      std::vector<IEntity*> & result)
+{
+	FUNCTION_PROFILER(gEnv->pSystem, PROFILE_GAME);
+
+	result.clear();
+
+	if (radius < 0)
+	{
+		return;
+	}
+
+	const int minX = ToCellCoord(center.x - radius);
+	const int minY = ToCellCoord(center.y - radius);
+	const int minZ = ToCellCoord(center.z - radius);
+	const int maxX = ToCellCoord(center.x + radius);
+	const int maxY = ToCellCoord(center.y + radius);
+	const int maxZ = ToCellCoord(center.z + radius);
+
+	const double cellCount = double(maxX - minX + 1) * double(maxY - minY + 1) * double(maxZ - minZ + 1);
+
+	if (pClass)
+	{
+		const auto it = m_classes.find(pClass);
+		if (it == m_classes.end())
+		{
+			return;
+		}
+
+		// a small class is cheaper to check directly
+		if (it->second.size() <= cellCount)
+		{
+			AddCandidates(it->second, center, radius, nullptr, result);
+			return;
+		}
+	}
+
+	if (cellCount > m_cells.size())
+	{
+		// huge sphere, check all occupied cells instead
+		for (const auto & [key, bucket] : m_cells)
+		{
+			AddCandidates(bucket, center, radius, pClass, result);
+		}
+
+		return;
+	}
+
+	for (int x = minX; x <= maxX; x++)
+	{
+		for (int y = minY; y <= maxY; y++)
+		{
+			for (int z = minZ; z <= maxZ; z++)
+			{
+				const auto it = m_cells.find(ToCellKey(x, y, z));
+
+				if (it != m_cells.end())
+				{
+					AddCandidates(it->second, center, radius, pClass, result);
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+#include "CryCommon/CryEntitySystem/IEntitySystem.h"
+
+// per-class buckets and uniform grid of all entities for script queries
+// spawn and removal come from the entity system sink in Client, movement from entity event listeners
+class EntityIndex : public IEntityEventListener
+{
+	static constexpr float CELL_SIZE = 32;
+
+	struct Entry
+	{
+		IEntityClass *pClass = nullptr;
+		uint64_t cell = 0;
+		size_t classPos = 0;
+		size_t cellPos = 0;
+	};
+
+	using Bucket = std::vector<EntityId>;
+
+	std::unordered_map<EntityId, Entry> m_entities;
+	std::unordered_map<IEntityClass*, Bucket> m_classes;
+	std::unordered_map<uint64_t, Bucket> m_cells;
+
+	static int ToCellCoord(float value);
+	static uint64_t ToCellKey(int x, int y, int z);
+	static uint64_t ToCellKey(const Vec3 & pos);
+
+	void AddToBucket(Bucket & bucket, EntityId id, size_t & pos);
+	void RemoveFromBucket(Bucket & bucket, size_t pos, bool isCell);
+
+	void OnMove(IEntity *pEntity);
+
+	void AddCandidates(const Bucket & bucket, const Vec3 & center, float radius, IEntityClass *pClass,
+	                   std::vector<IEntity*> & result);
+
+public:
+	EntityIndex();
+	~EntityIndex();
+
+	void OnSpawn(IEntity *pEntity);
+	void OnRemove(IEntity *pEntity);
+
+	// IEntityEventListener
+	void OnEntityEvent(IEntity *pEntity, SEntityEvent & event) override;
+
+	// the result is cleared first, entities are in no particular order
+	void GetEntitiesByClass(IEntityClass *pClass, std::vector<IEntity*> & result);
+	void GetEntitiesInSphere(const Vec3 & center, float radius, IEntityClass *pClass, std::vector<IEntity*> & result);
+};
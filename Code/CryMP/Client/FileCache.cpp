@@ -10,7 +10,7 @@
 #include "Client.h"
 #include "FileDownloader.h"
 
-json FileCache::LoadIndex()
+void FileCache::LoadIndex()
 {
 	json index;
 
@@ -40,20 +40,125 @@ json FileCache::LoadIndex()
 	if (!index.contains("lru") || !index["lru"].is_array())
 		index["lru"] = json::array();
 
-	return index;
+	if (!index.contains("sizes") || !index["sizes"].is_object())
+		index["sizes"] = json::object();
+
+	const json & files = index["files"];
+	const json & sizes = index["sizes"];
+
+	for (const json & item : index["lru"])
+	{
+		if (!item.is_string())
+		{
+			continue;
+		}
+
+		const std::string & hash = item.get_ref<const std::string&>();
+
+		if (m_index.count(hash))
+		{
+			continue;
+		}
+
+		IndexEntry entry;
+		entry.hash = hash;
+
+		auto fileIt = files.find(hash);
+		if (fileIt != files.end() && fileIt->is_string())
+		{
+			entry.path = fileIt->get<std::string>();
+		}
+
+		auto sizeIt = sizes.find(hash);
+		if (sizeIt != sizes.end() && sizeIt->is_number_unsigned())
+		{
+			entry.size = sizeIt->get<uint64_t>();
+		}
+
+		m_index[hash] = m_lru.insert(m_lru.end(), std::move(entry));
+	}
+}
+
+void FileCache::ReplayJournal()
+{
+	std::string content;
+
+	try
+	{
+		WinAPI::File journalFile(m_cacheDir / "journal", WinAPI::FileAccess::READ_ONLY);
+		if (journalFile)
+		{
+			content = journalFile.Read();
+		}
+	}
+	catch (const std::exception & ex)
+	{
+		CryLogAlways("$4[CryMP] [FileCache] Journal load error: %s", ex.what());
+	}
+
+	for (const std::string_view & line : Util::SplitLines(content))
+	{
+		// the last record might be incomplete after a crash
+		const json record = json::parse(line, nullptr, false);
+
+		if (!record.is_object() || !record.contains("hash") || !record["hash"].is_string())
+		{
+			continue;
+		}
+
+		const std::string & hash = record["hash"].get_ref<const std::string&>();
+
+		if (record.value("remove", false))
+		{
+			RemoveEntry(hash);
+			continue;
+		}
+
+		TouchEntry(hash, record.value("path", std::string()));
+
+		if (record.contains("size") && record["size"].is_number_unsigned())
+		{
+			m_index[hash]->size = record["size"].get<uint64_t>();
+		}
+	}
 }
 
-void FileCache::SaveIndex(const json & index)
+void FileCache::CompactIndex()
 {
+	json index;
+	index["files"] = json::object();
+	index["sizes"] = json::object();
+	index["lru"] = json::array();
+
+	for (const IndexEntry & entry : m_lru)
+	{
+		index["files"][entry.hash] = entry.path;
+		index["lru"].emplace_back(entry.hash);
+
+		if (entry.size)
+		{
+			index["sizes"][entry.hash] = entry.size;
+		}
+	}
+
 	try
 	{
-		WinAPI::File indexFile(m_cacheDir / "index", WinAPI::FileAccess::WRITE_ONLY);
+		WinAPI::File indexFile(m_cacheDir / "index", WinAPI::FileAccess::WRITE_ONLY_CREATE);
 		if (!indexFile)
 		{
 			throw StringTools::SysErrorFormat("Failed to open the index file for writing");
 		}
 
+		indexFile.Resize(0);
 		indexFile.Write(index.dump());
+
+		// everything from the journal is in the index file now
+		if (m_journal)
+		{
+			m_journal.Resize(0);
+		}
+
+		m_journalLength = 0;
 	}
 	catch (const std::exception & ex)
 	{
@@ -61,6 +166,66 @@ void FileCache::SaveIndex(const json & index)
 	}
 }
 
+void FileCache::AppendJournal(const json & record)
+{
+	// compact the journal once it grows enough
+	constexpr unsigned int MAX_JOURNAL_LENGTH = 256;
+
+	if (!m_journal)
+	{
+		return;
+	}
+
+	try
+	{
+		m_journal.Write(record.dump() + "\n");
+	}
+	catch (const std::exception & ex)
+	{
+		CryLogAlways("$4[CryMP] [FileCache] Journal write error: %s", ex.what());
+	}
+
+	if (++m_journalLength >= MAX_JOURNAL_LENGTH)
+	{
+		CompactIndex();
+	}
+}
+
+void FileCache::TouchEntry(const std::string & hash, const std::string_view & path)
+{
+	auto it = m_index.find(hash);
+
+	if (it == m_index.end())
+	{
+		IndexEntry entry;
+		entry.hash = hash;
+		entry.path = path;
+
+		m_index[hash] = m_lru.insert(m_lru.end(), std::move(entry));
+	}
+	else
+	{
+		// move to the most recently used end
+		m_lru.splice(m_lru.end(), m_lru, it->second);
+
+		if (!path.empty())
+		{
+			it->second->path = path;
+		}
+	}
+}
+
+void FileCache::RemoveEntry(const std::string & hash)
+{
+	auto it = m_index.find(hash);
+
+	if (it != m_index.end())
+	{
+		m_lru.erase(it->second);
+		m_index.erase(it);
+	}
+}
+
 void FileCache::DownloadFile(FileCacheRequest && request, const std::filesystem::path & filePath)
 {
 	FileDownloaderRequest download;
@@ -111,9 +276,24 @@ void FileCache::DownloadFile(FileCacheRequest && request, const std::filesystem:
 			success = true;
 		}
 
-		if (!success)
+		const std::string hash = result.filePath.filename().string();
+
+		if (success)
+		{
+			auto it = m_index.find(hash);
+			if (it != m_index.end())
+			{
+				it->second->size = result.downloadedBytes;
+
+				AppendJournal({ { "hash", hash }, { "path", it->second->path }, { "size", result.downloadedBytes } });
+			}
+		}
+		else
 		{
 			RemoveFile(result.filePath);
+			RemoveEntry(hash);
+
+			AppendJournal({ { "hash", hash }, { "remove", true } });
 		}
 
 		CompleteRequest(request, success, result.filePath);
@@ -150,12 +330,50 @@ FileCache::FileCache()
 	// make sure the cache directory exists
 	std::filesystem::create_directories(m_cacheDir);
 
-	// make sure the index file exists
-	WinAPI::File(m_cacheDir / "index", WinAPI::FileAccess::READ_WRITE_CREATE);
+	LoadIndex();
+	ReplayJournal();
+
+	// fill in sizes missing in older index files and drop such entries without a file
+	// entries with a known size are not checked, Request looks for the file anyway
+	for (auto it = m_lru.begin(); it != m_lru.end();)
+	{
+		if (it->size)
+		{
+			++it;
+			continue;
+		}
+
+		const std::filesystem::path filePath = m_cacheDir / it->hash;
+
+		std::error_code code;
+		const uint64_t size = std::filesystem::file_size(filePath, code);
+
+		if (code)
+		{
+			m_index.erase(it->hash);
+			it = m_lru.erase(it);
+		}
+		else
+		{
+			it->size = size;
+			++it;
+		}
+	}
+
+	if (!m_journal.Open(m_cacheDir / "journal", WinAPI::FileAccess::WRITE_ONLY_CREATE))
+	{
+		CryLogAlways("$4[CryMP] [FileCache] Failed to open the journal file");
+	}
+
+	CompactIndex();
 }
 
 FileCache::~FileCache()
 {
+	if (m_journalLength > 0)
+	{
+		CompactIndex();
+	}
 }
 
 void FileCache::Request(FileCacheRequest && request)
@@ -176,23 +394,16 @@ std::filesystem::path FileCache::GetPath(const std::string_view & path)
 {
 	const std::string hash = Util::SHA256(path);
 
-	json index = LoadIndex();
-	json & lru = index["lru"];
+	auto it = m_index.find(hash);
 
-	auto it = std::find_if(lru.begin(), lru.end(), [&hash](const json & item)
+	// nothing to record if the entry is already the most recently used one
+	if (it == m_index.end() || std::next(it->second) != m_lru.end())
 	{
-		return item.is_string() && item.get_ref<const std::string&>() == hash;
-	});
+		TouchEntry(hash, path);
 
-	if (it == lru.end())
-	{
-		lru.emplace_back(hash);
+		AppendJournal({ { "hash", hash }, { "path", std::string(path) } });
 	}
 
-	index["files"][hash] = path;
-
-	SaveIndex(index);
-
 	return m_cacheDir / hash;
 }
 
@@ -200,40 +411,21 @@ std::deque<FileCacheEntry> FileCache::LoadEntries()
 {
 	std::deque<FileCacheEntry> entries;
 
-	json index = LoadIndex();
-
 	unsigned int order = 0;
-	unsigned int removedCount = 0;
-	std::vector<std::string> newEntries;
 
-	for (const json & item : index["lru"])
+	for (const IndexEntry & indexEntry : m_lru)
 	{
-		if (item.is_string())
+		// files being downloaded have no size yet
+		if (indexEntry.size == 0)
 		{
-			FileCacheEntry entry;
-			entry.hash = item.get<std::string>();
-			entry.path = m_cacheDir / entry.hash;
-
-			if (std::filesystem::exists(entry.path))
-			{
-				entry.size = std::filesystem::file_size(entry.path);
-				entry.order = order++;
-
-				newEntries.emplace_back(entry.hash);
-				entries.emplace_back(std::move(entry));
-			}
-			else
-			{
-				removedCount++;
-			}
+			continue;
 		}
-	}
 
-	if (removedCount > 0)
-	{
-		index["lru"] = newEntries;
-
-		SaveIndex(index);
+		FileCacheEntry & entry = entries.emplace_back();
+		entry.hash = indexEntry.hash;
+		entry.path = m_cacheDir / indexEntry.hash;
+		entry.size = indexEntry.size;
+		entry.order = order++;
 	}
 
 	return entries;
@@ -259,6 +451,9 @@ std::deque<FileCacheEntry> FileCache::Cleanup()
 		FileCacheEntry & entryToRemove = entries.front();
 
 		RemoveFile(entryToRemove.path);
+		RemoveEntry(entryToRemove.hash);
+
+		AppendJournal({ { "hash", entryToRemove.hash }, { "remove", true } });
 
 		cacheSize -= entryToRemove.size;
 
@@ -266,8 +461,5 @@ std::deque<FileCacheEntry> FileCache::Cleanup()
 		entries.pop_front();
 	}
 
-	// Clean-up LRU array inside index
-	LoadEntries();
-
 	return removed;
 }
@@ -6,9 +6,13 @@
 #include <functional>
 #include <filesystem>
 #include <deque>
+#include <list>
+#include <unordered_map>
 
 #include <nlohmann/json.hpp>
 
+#include "Library/WinAPI.h"
+
 using json = nlohmann::json;
 
 struct FileCacheResult
@@ -35,10 +39,29 @@ struct FileCacheEntry
 
 class FileCache
 {
+	struct IndexEntry
+	{
+		std::string hash;
+		std::string path;   // the original path or URL
+		uint64_t size = 0;  // zero if not known yet
+	};
+
+	using IndexList = std::list<IndexEntry>;  // least recently used first
+
 	std::filesystem::path m_cacheDir;
 
-	json LoadIndex();
-	void SaveIndex(const json & index);
+	// the index is kept in memory, changes are appended to the journal and compacted into the index file
+	IndexList m_lru;
+	std::unordered_map<std::string, IndexList::iterator> m_index;
+	WinAPI::File m_journal;
+	unsigned int m_journalLength = 0;
+
+	void LoadIndex();
+	void ReplayJournal();
+	void CompactIndex();
+	void AppendJournal(const json & record);
+	void TouchEntry(const std::string & hash, const std::string_view & path);
+	void RemoveEntry(const std::string & hash);
 	void DownloadFile(FileCacheRequest && request, const std::filesystem::path & filePath);
 	void RemoveFile(const std::filesystem::path & path);
 	void CompleteRequest(const FileCacheRequest & request, bool success, const std::filesystem::path & filePath);
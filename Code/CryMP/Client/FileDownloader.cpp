@@ -1,5 +1,12 @@
+#include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "CryCommon/CrySystem/ISystem.h"
 
 #include "CryMP/Common/Executor.h"
 #include "Library/StringTools.h"
@@ -15,7 +22,7 @@ class OutputFile
 	WinAPI::File m_file;
 
 public:
-	OutputFile(const std::filesystem::path & path)
+	OutputFile(const std::filesystem::path & path, bool keepContent)
 	{
 		bool created = false;
 
@@ -24,16 +31,40 @@ public:
 			throw StringTools::SysErrorFormat("Failed to open the output file");
 		}
 
-		if (!created)
+		if (!created && !keepContent)
 		{
 			// clear the existing file
 			m_file.Resize(0);
 		}
 	}
 
-	void Write(const char *chunk, size_t chunkLength)
+	uint64_t GetSize()
+	{
+		return m_file.Seek(WinAPI::FileSeekBase::END);
+	}
+
+	void Resize(uint64_t size)
+	{
+		m_file.Resize(size);
+	}
+
+	// thread-safe
+	void WriteAt(uint64_t offset, const char *chunk, size_t chunkLength)
+	{
+		m_file.WriteAt(offset, std::string_view(chunk, chunkLength));
+	}
+};
+
+struct FileDownloaderSegment
+{
+	uint64_t begin = 0;
+	uint64_t end = 0;  // zero means until the end of the response
+	uint64_t position = 0;
+	std::string error;
+
+	bool IsComplete() const
 	{
-		m_file.Write(std::string_view(chunk, chunkLength));
+		return end && position == end;
 	}
 };
 
@@ -42,11 +73,19 @@ struct FileDownloaderTask : public IExecutorTask
 	FileDownloaderRequest request;
 	FileDownloaderResult result;
 	SpeedAggregator speedAggregator;
+	std::mutex progressMutex;
 	std::atomic<bool> isActive;
+	std::atomic<uint64_t> downloadedBytes;
 	std::chrono::time_point<std::chrono::steady_clock> lastProgressUpdate;
 
+	// segments smaller than this are not worth an extra connection
+	static constexpr uint64_t MIN_SEGMENT_SIZE = 1024 * 1024;
+
 	void UpdateProgress(size_t chunkLength)
 	{
+		// called from all segment threads
+		std::lock_guard<std::mutex> lock(progressMutex);
+
 		const auto now = std::chrono::steady_clock::now();
 
 		speedAggregator.push(chunkLength);
@@ -56,7 +95,7 @@ struct FileDownloaderTask : public IExecutorTask
 			FileDownloaderProgress progress;
 			progress.speed = speedAggregator.getSpeed();
 			progress.contentLength = result.contentLength;
-			progress.downloadedBytes = result.downloadedBytes;
+			progress.downloadedBytes = downloadedBytes;
 
 			gClient->GetExecutor()->RunOnMainThread([this, progress]() mutable
 			{
@@ -70,42 +109,258 @@ struct FileDownloaderTask : public IExecutorTask
 		}
 	}
 
-	// worker thread
-	void Execute() override
+	void ReadSegment(OutputFile & file, FileDownloaderSegment & segment, const WinAPI::HTTPRequestReader & reader)
 	{
-		isActive = true;
+		while (isActive && (!segment.end || segment.position < segment.end))
+		{
+			char chunk[8192];
+			size_t chunkSize = sizeof chunk;
+
+			if (segment.end && (segment.end - segment.position) < chunkSize)
+			{
+				chunkSize = static_cast<size_t>(segment.end - segment.position);
+			}
+
+			const size_t chunkLength = reader(chunk, chunkSize);
+
+			if (chunkLength == 0)
+				break;
+
+			file.WriteAt(segment.position, chunk, chunkLength);
 
+			if (request.onData)
+			{
+				request.onData(segment.position, chunk, chunkLength);
+			}
+
+			segment.position += chunkLength;
+			downloadedBytes += chunkLength;
+
+			UpdateProgress(chunkLength);
+		}
+	}
+
+	// segment thread
+	void DownloadSegment(OutputFile & file, FileDownloaderSegment & segment)
+	{
 		try
 		{
-			OutputFile file(request.filePath);
+			std::map<std::string, std::string> headers;
+			headers["Range"] = "bytes=" + std::to_string(segment.begin) + "-" + std::to_string(segment.end - 1);
 
-			result.statusCode = WinAPI::HTTPRequest(
+			WinAPI::HTTPRequest(
 				"GET",
 				request.url,
 				{},  // data
-				{},  // headers
+				headers,
 				request.timeout,
-				[this, &file](uint64_t contentLength, const WinAPI::HTTPRequestReader & reader)
+				[this, &file, &segment](int statusCode, uint64_t contentLength, const WinAPI::HTTPRequestReader & reader)
 				{
-					// content length is zero if not provided by the server
-					result.contentLength = contentLength;
+					if (statusCode != HTTP::STATUS_PARTIAL_CONTENT || contentLength != (segment.end - segment.begin))
+					{
+						throw StringTools::ErrorFormat("Segment request failed with status code %d", statusCode);
+					}
+
+					ReadSegment(file, segment, reader);
+				}
+			);
+
+			if (isActive && !segment.IsComplete())
+			{
+				throw StringTools::ErrorFormat("Incomplete segment");
+			}
+		}
+		catch (const std::exception& ex)
+		{
+			segment.error = ex.what();
+
+			// no point in continuing without the whole file
+			isActive = false;
+		}
+	}
+
+	// splits the rest of the file after the first segment between additional connections
+	void StartSegments(OutputFile & file, std::vector<FileDownloaderSegment> & segments, std::vector<std::thread> & threads)
+	{
+		const uint64_t begin = segments[0].begin;
+		const uint64_t totalSize = result.contentLength;
+		const uint64_t remainingSize = totalSize - begin;
+
+		uint64_t segmentCount = std::min<uint64_t>(request.segmentCount, remainingSize / MIN_SEGMENT_SIZE);
+		if (segmentCount < 2)
+		{
+			return;
+		}
+
+		// all segments write into the preallocated file at their offsets
+		file.Resize(totalSize);
+
+		const uint64_t segmentSize = remainingSize / segmentCount;
+
+		segments.resize(segmentCount);
+
+		for (uint64_t i = 0; i < segmentCount; i++)
+		{
+			FileDownloaderSegment & segment = segments[i];
+			segment.begin = begin + (i * segmentSize);
+			segment.end = (i + 1 < segmentCount) ? segment.begin + segmentSize : totalSize;
+			segment.position = segment.begin;
+		}
+
+		// the first segment is downloaded by the already open connection
+		for (uint64_t i = 1; i < segmentCount; i++)
+		{
+			threads.emplace_back(&FileDownloaderTask::DownloadSegment, this, std::ref(file), std::ref(segments[i]));
+		}
+	}
+
+	// keeps only the contiguous downloaded part of the file, so the download can be resumed later
+	uint64_t TrimToContiguous(OutputFile & file, const std::vector<FileDownloaderSegment> & segments)
+	{
+		uint64_t fileSize = segments[0].position;
+
+		for (const FileDownloaderSegment & segment : segments)
+		{
+			fileSize = segment.position;
 
-					while (isActive)
+			if (!segment.IsComplete())
+			{
+				break;
+			}
+		}
+
+		if (segments.size() > 1 && fileSize != result.contentLength)
+		{
+			file.Resize(fileSize);
+		}
+
+		return fileSize;
+	}
+
+	void Download(OutputFile & file, uint64_t offset)
+	{
+		std::vector<FileDownloaderSegment> segments(1);
+		segments[0].begin = offset;
+		segments[0].position = offset;
+
+		std::vector<std::thread> threads;
+
+		std::map<std::string, std::string> headers;
+
+		if (offset > 0 || request.segmentCount > 1)
+		{
+			headers["Range"] = "bytes=" + std::to_string(offset) + "-";
+		}
+
+		downloadedBytes = offset;
+
+		try
+		{
+			result.statusCode = WinAPI::HTTPRequest(
+				"GET",
+				request.url,
+				{},  // data
+				headers,
+				request.timeout,
+				[&](int statusCode, uint64_t contentLength, const WinAPI::HTTPRequestReader & reader)
+				{
+					if (statusCode == HTTP::STATUS_RANGE_NOT_SATISFIABLE)
 					{
-						char chunk[8192];
-						const size_t chunkLength = reader(chunk, sizeof chunk);
+						return;
+					}
 
-						if (chunkLength == 0)
-							break;
+					if (statusCode == HTTP::STATUS_PARTIAL_CONTENT)
+					{
+						// content length is zero if not provided by the server
+						result.contentLength = contentLength ? offset + contentLength : 0;
 
-						file.Write(chunk, chunkLength);
-						result.downloadedBytes += chunkLength;
+						if (result.contentLength && request.segmentCount > 1)
+						{
+							StartSegments(file, segments, threads);
+						}
+					}
+					else
+					{
+						// the server ignored the range and sends the whole file
+						if (offset > 0)
+						{
+							file.Resize(0);
+						}
 
-						UpdateProgress(chunkLength);
+						result.contentLength = contentLength;
+						segments[0].begin = 0;
+						segments[0].position = 0;
+						downloadedBytes = 0;
 					}
+
+					ReadSegment(file, segments[0], reader);
 				}
 			);
 		}
+		catch (...)
+		{
+			isActive = false;
+
+			for (std::thread & thread : threads)
+			{
+				thread.join();
+			}
+
+			// the preallocated file would look complete to the next resume
+			result.downloadedBytes = TrimToContiguous(file, segments);
+
+			throw;
+		}
+
+		for (std::thread & thread : threads)
+		{
+			thread.join();
+		}
+
+		if (result.statusCode == HTTP::STATUS_PARTIAL_CONTENT)
+		{
+			// the response continued or assembled the file, so report it as a complete one
+			result.statusCode = HTTP::STATUS_OK;
+		}
+
+		result.downloadedBytes = TrimToContiguous(file, segments);
+
+		for (const FileDownloaderSegment & segment : segments)
+		{
+			if (!segment.error.empty())
+			{
+				throw StringTools::ErrorFormat("%s", segment.error.c_str());
+			}
+		}
+	}
+
+	// worker thread
+	void Execute() override
+	{
+		isActive = true;
+
+		try
+		{
+			OutputFile file(request.filePath, request.resume);
+
+			const uint64_t offset = request.resume ? file.GetSize() : 0;
+
+			if (offset > 0)
+			{
+				CryLog("$3[CryMP] [FileDownloader] Resuming %s from %llu bytes",
+					request.filePath.string().c_str(), static_cast<unsigned long long>(offset));
+			}
+
+			Download(file, offset);
+
+			if (result.statusCode == HTTP::STATUS_RANGE_NOT_SATISFIABLE && offset > 0)
+			{
+				// the existing file does not match the remote one, start over
+				file.Resize(0);
+
+				Download(file, 0);
+			}
+		}
 		catch (const std::exception& ex)
 		{
 			result.error = ex.what();
@@ -117,7 +372,7 @@ struct FileDownloaderTask : public IExecutorTask
 	{
 		if (request.onComplete)
 		{
-			result.canceled = !isActive;
+			result.canceled = !isActive && result.error.empty();
 			result.filePath = std::move(request.filePath);
 
 			request.onComplete(result);
@@ -156,5 +411,5 @@ void FileDownloader::Request(FileDownloaderRequest && request)
 	std::unique_ptr<FileDownloaderTask> task = std::make_unique<FileDownloaderTask>();
 	task->request = std::move(request);
 
-	gClient->GetExecutor()->AddTask(std::move(task));
+	gClient->GetExecutor()->AddTask(std::move(task), ExecutorLane::BULK);
 }
@@ -31,8 +31,11 @@ struct FileDownloaderRequest
 	std::string url;
 	std::filesystem::path filePath;
 	std::function<bool(FileDownloaderProgress&)> onProgress;  // return false to cancel download
+	std::function<void(uint64_t,const char*,size_t)> onData;  // file offset, data, data length; download threads
 	std::function<void(FileDownloaderResult&)> onComplete;
 	int timeout = 4000;
+	bool resume = false;            // continue an existing partial file using an HTTP range request
+	unsigned int segmentCount = 1;  // parallel connections, used only if the server supports range requests
 };
 
 class FileDownloader
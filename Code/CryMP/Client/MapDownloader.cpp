@@ -1,12 +1,16 @@
+#include <cctype>
+
 #include "CryCommon/CrySystem/ISystem.h"
 #include "CryCommon/CrySystem/ICryPak.h"
 #include "CryCommon/CryAction/IGameFramework.h"
 #include "CryCommon/CryAction/ILevelSystem.h"
+#include "CryMP/Common/Executor.h"
 #include "Library/Util.h"
 #include "Library/WinAPI.h"
 
 #include "MapDownloader.h"
 #include "MapExtractor.h"
+#include "MapStore.h"
 #include "Client.h"
 #include "FileDownloader.h"
 #include "FileRedirector.h"
@@ -14,11 +18,27 @@
 void MapDownloader::DownloadMap(MapDownloaderRequest && request)
 {
 	// convert "multiplayer/ps/mymap" to "mymap.zip"
-	const std::string zipFileName = std::filesystem::path(request.map).filename().string() + ".zip";
+	std::string zipFileName = std::filesystem::path(request.map).filename().string();
+
+	// a partial file is resumed only by a download of the same map version
+	// without a version, nothing tells an older partial file apart, so the download starts over
+	if (!request.mapVersion.empty())
+	{
+		zipFileName += '-';
+
+		for (char ch : request.mapVersion)
+		{
+			zipFileName += (std::isalnum(static_cast<unsigned char>(ch)) || ch == '.') ? ch : '_';
+		}
+	}
+
+	zipFileName += ".zip";
 
 	FileDownloaderRequest download;
 	download.url = request.mapURL;
 	download.filePath = m_downloadDir / zipFileName;
+	download.resume = !request.mapVersion.empty();
+	download.segmentCount = 4;
 
 	CryLogAlways("$3[CryMP] [MapDownloader] Downloading map $6%s$3", request.map.c_str());
 
@@ -42,17 +62,42 @@ void MapDownloader::DownloadMap(MapDownloaderRequest && request)
 		}
 	};
 
-	download.onComplete = [request = std::move(request), this](FileDownloaderResult & result)
+	std::shared_ptr<MapExtractor> extractor;
+
+	try
+	{
+		extractor = std::make_shared<MapExtractor>(download.filePath, request.map, m_store.get());
+	}
+	catch (const std::exception & ex)
+	{
+		CryLogAlways("$4[CryMP] [MapDownloader] Extract error: %s", ex.what());
+		CompleteRequest(request, false);
+		return;
+	}
+
+	// extract the map while it is being downloaded
+	download.onData = [extractor](uint64_t offset, const char *data, size_t length)
+	{
+		extractor->OnData(offset, data, length);
+	};
+
+	download.onComplete = [request = std::move(request), extractor, this](FileDownloaderResult & result)
 	{
-		bool success = false;
+		bool downloaded = false;
+		bool keepZip = false;
 
 		if (!result.error.empty())
 		{
 			CryLogAlways("$4[CryMP] [MapDownloader] Download error: %s", result.error.c_str());
+
+			// the next attempt continues from where this one stopped
+			keepZip = true;
 		}
 		else if (result.canceled)
 		{
 			CryLogAlways("$6[CryMP] [MapDownloader] Download canceled!");
+
+			keepZip = true;
 		}
 		else if (result.statusCode != HTTP::STATUS_OK)
 		{
@@ -68,59 +113,93 @@ void MapDownloader::DownloadMap(MapDownloaderRequest && request)
 		else if (result.contentLength && result.contentLength != result.downloadedBytes)
 		{
 			CryLogAlways("$4[CryMP] [MapDownloader] Incomplete file!");
+
+			keepZip = result.contentLength > result.downloadedBytes;
 		}
 		else
 		{
-			CryLogAlways("$3[CryMP] [MapDownloader] Download finished, extracting...");
-			if (request.onProgress)
+			downloaded = true;
+		}
+
+		if (!downloaded)
+		{
+			extractor->Abort();
+
+			if (!keepZip)
 			{
-				request.onProgress("Extracting map...");
+				RemoveZip(result.filePath);
 			}
 
-			success = UnpackMap(result.filePath, request.map);
+			CompleteRequest(request, false);
+			return;
+		}
 
-			if (success)
+		CryLogAlways("$3[CryMP] [MapDownloader] Download finished, extracting...");
+		if (request.onProgress)
+		{
+			request.onProgress("Extracting map...");
+		}
+
+		auto error = std::make_shared<std::string>();
+
+		// whatever was not extracted during the download is extracted on worker threads
+		gClient->GetExecutor()->RunAsync(
+			[extractor, error]()
 			{
-				if (!request.mapVersion.empty())
+				try
 				{
-					StoreMapVersion(request.map, request.mapVersion);
+					extractor->Extract();
 				}
-
-				CryLogAlways("$3[CryMP] [MapDownloader] Map extracted, checking map folder...");
-				if (request.onProgress)
+				catch (const std::exception & ex)
 				{
-					request.onProgress("Checking map folder...");
+					*error = ex.what();
 				}
-
-				RescanMaps();
-
-				gClient->GetFileRedirector()->GetDownloadedMaps().Add(request.map);
-
-				CryLogAlways("$3[CryMP] [MapDownloader] Map downloaded successfully");
-			}
-		}
-
-		RemoveZip(result.filePath);
-
-		CompleteRequest(request, success);
+			},
+			[request, extractor, error, zipPath = result.filePath, this]()
+			{
+				OnMapExtracted(request, zipPath, *extractor, *error);
+			},
+			ExecutorLane::BULK
+		);
 	};
 
 	gClient->GetFileDownloader()->Request(std::move(download));
 }
 
-bool MapDownloader::UnpackMap(const std::filesystem::path & zipPath, const std::string_view & mapName)
+void MapDownloader::OnMapExtracted(const MapDownloaderRequest & request, const std::filesystem::path & zipPath,
+                                   MapExtractor & extractor, const std::string & error)
 {
-	try
+	const bool success = error.empty();
+
+	if (!success)
 	{
-		MapExtractor(zipPath, mapName).Extract();
+		CryLogAlways("$4[CryMP] [MapDownloader] Extract error: %s", error.c_str());
+
+		extractor.Abort();
 	}
-	catch (const std::exception & ex)
+	else
 	{
-		CryLogAlways("$4[CryMP] [MapDownloader] Extract error: %s", ex.what());
-		return false;
+		if (!request.mapVersion.empty())
+		{
+			StoreMapVersion(request.map, request.mapVersion);
+		}
+
+		CryLogAlways("$3[CryMP] [MapDownloader] Map extracted, checking map folder...");
+		if (request.onProgress)
+		{
+			request.onProgress("Checking map folder...");
+		}
+
+		RescanMaps();
+
+		gClient->GetFileRedirector()->GetDownloadedMaps().Add(request.map);
+
+		CryLogAlways("$3[CryMP] [MapDownloader] Map downloaded successfully");
 	}
 
-	return true;
+	RemoveZip(zipPath);
+
+	CompleteRequest(request, success);
 }
 
 void MapDownloader::RemoveZip(const std::filesystem::path & zipPath)
@@ -237,8 +316,16 @@ MapDownloader::MapDownloader()
 	// make sure the map directory exists
 	std::filesystem::create_directories(m_downloadDir / "Levels");
 
+	// maps whose extraction was interrupted
+	std::error_code code;
+	std::filesystem::remove_all(m_downloadDir / "Extracting", code);
+
 	gClient->GetFileRedirector()->GetDownloadedMaps().SetDownloadPath("%USER%/Downloads/Levels");
 
+	// files shared between maps are stored only once
+	m_store = std::make_unique<MapStore>(m_downloadDir / "Store");
+	m_store->Cleanup();
+
 	RescanMaps();
 	RegisterDownloadedMaps();
 }
@@ -4,6 +4,10 @@
 #include <string_view>
 #include <functional>
 #include <filesystem>
+#include <memory>
+
+class MapExtractor;
+class MapStore;
 
 struct MapDownloaderResult
 {
@@ -23,9 +27,11 @@ struct MapDownloaderRequest
 class MapDownloader
 {
 	std::filesystem::path m_downloadDir;
+	std::unique_ptr<MapStore> m_store;
 
 	void DownloadMap(MapDownloaderRequest && request);
-	bool UnpackMap(const std::filesystem::path & zipPath, const std::string_view & mapName);
+	void OnMapExtracted(const MapDownloaderRequest & request, const std::filesystem::path & zipPath,
+	                    MapExtractor & extractor, const std::string & error);
 	void RemoveZip(const std::filesystem::path & zipPath);
 	bool CheckMapExists(const std::string_view & mapName);
 	bool CheckMapVersion(const std::string_view & mapName, const std::string_view & mapVersion);
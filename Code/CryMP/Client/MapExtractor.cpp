@@ -1,80 +1,644 @@
+#include <algorithm>
+#include <thread>
+
 #include "CryCommon/CrySystem/ISystem.h"
 #include "Library/StringTools.h"
 #include "Library/Util.h"
 
 #include "MapExtractor.h"
+#include "MapStore.h"
+
+namespace
+{
+	constexpr uint32_t ZIP_LOCAL_HEADER_SIGNATURE = 0x04034B50;
+	constexpr uint32_t ZIP_DATA_DESCRIPTOR_SIGNATURE = 0x08074B50;
+
+	constexpr size_t ZIP_LOCAL_HEADER_SIZE = 30;
+	constexpr size_t ZIP_DATA_DESCRIPTOR_SIZE = 12;  // without the optional signature
+
+	constexpr uint16_t ZIP_FLAG_ENCRYPTED = 0x1;
+	constexpr uint16_t ZIP_FLAG_DATA_DESCRIPTOR = 0x8;
+
+	constexpr uint16_t ZIP_METHOD_STORED = 0;
+	constexpr uint16_t ZIP_METHOD_DEFLATED = 8;
+
+	uint16_t ReadU16(const char *data)
+	{
+		const auto *bytes = reinterpret_cast<const uint8_t*>(data);
+
+		return bytes[0] | (bytes[1] << 8);
+	}
+
+	uint32_t ReadU32(const char *data)
+	{
+		const auto *bytes = reinterpret_cast<const uint8_t*>(data);
+
+		return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+	}
+
+	class ZipReader
+	{
+		mz_zip_archive m_zip;
+
+	public:
+		explicit ZipReader(const std::filesystem::path & zipPath)
+		{
+			mz_zip_zero_struct(&m_zip);
+
+			if (!mz_zip_reader_init_file(&m_zip, zipPath.string().c_str(), 0))
+			{
+				throw StringTools::ErrorFormat("ZIP open: %s", GetErrorString());
+			}
+		}
+
+		ZipReader(const ZipReader &) = delete;
+		ZipReader & operator=(const ZipReader &) = delete;
+
+		~ZipReader()
+		{
+			mz_zip_reader_end(&m_zip);
+		}
+
+		const char* GetErrorString()
+		{
+			return mz_zip_get_error_string(mz_zip_peek_last_error(&m_zip));
+		}
+
+		unsigned int GetFileCount()
+		{
+			return mz_zip_reader_get_num_files(&m_zip);
+		}
+
+		bool IsDirectory(unsigned int index)
+		{
+			return mz_zip_reader_is_file_a_directory(&m_zip, index);
+		}
+
+		std::string GetFileName(unsigned int index)
+		{
+			char buffer[512];
+			if (!mz_zip_reader_get_filename(&m_zip, index, buffer, sizeof buffer))
+			{
+				throw StringTools::ErrorFormat("ZIP get filename: %s", GetErrorString());
+			}
+
+			return buffer;
+		}
+
+		// returns SHA-256 of the extracted content
+		std::string ExtractFile(unsigned int index, const std::filesystem::path & filePath)
+		{
+			struct Output
+			{
+				WinAPI::File file;
+				picosha2::hash256_one_by_one hasher;
+			};
+
+			Output output;
+
+			if (!output.file.Open(filePath, WinAPI::FileAccess::WRITE_ONLY_CREATE))
+			{
+				throw StringTools::SysErrorFormat("Failed to open '%s'", filePath.string().c_str());
+			}
+
+			output.file.Resize(0);
+
+			auto write = [](void *pOpaque, mz_uint64 offset, const void *data, size_t length) -> size_t
+			{
+				Output *pOutput = static_cast<Output*>(pOpaque);
+				const mz_uint8 *bytes = static_cast<const mz_uint8*>(data);
+
+				try
+				{
+					pOutput->file.Write(std::string_view(static_cast<const char*>(data), length));
+				}
+				catch (const std::exception &)
+				{
+					// miniz reports a write error
+					return 0;
+				}
+
+				pOutput->hasher.process(bytes, bytes + length);
+
+				return length;
+			};
+
+			// the CRC is verified by miniz
+			if (!mz_zip_reader_extract_to_callback(&m_zip, index, write, &output, 0))
+			{
+				throw StringTools::ErrorFormat("ZIP extract: %s", GetErrorString());
+			}
+
+			output.hasher.finish();
+
+			return picosha2::get_hash_hex_string(output.hasher);
+		}
+	};
+}
+
+bool MapExtractor::FillStreamBuffer(const mz_uint8 *& data, size_t & length)
+{
+	const size_t count = std::min(m_streamWanted - m_streamBuffer.length(), length);
+
+	m_streamBuffer.append(reinterpret_cast<const char*>(data), count);
+	data += count;
+	length -= count;
+
+	return m_streamBuffer.length() == m_streamWanted;
+}
+
+void MapExtractor::Stream(const mz_uint8 *data, size_t length)
+{
+	while (length > 0 && m_streamState != StreamState::DONE && m_streamState != StreamState::FAILED)
+	{
+		switch (m_streamState)
+		{
+			case StreamState::HEADER:
+			{
+				if (FillStreamBuffer(data, length))
+				{
+					BeginStreamEntry();
+				}
+				break;
+			}
+			case StreamState::NAME:
+			{
+				if (FillStreamBuffer(data, length))
+				{
+					OpenStreamEntry();
+				}
+				break;
+			}
+			case StreamState::DATA:
+			{
+				StreamEntryData(data, length);
+				break;
+			}
+			case StreamState::DESCRIPTOR:
+			{
+				if (FillStreamBuffer(data, length))
+				{
+					const bool hasSignature = (ReadU32(m_streamBuffer.data()) == ZIP_DATA_DESCRIPTOR_SIGNATURE);
+
+					if (hasSignature && m_streamWanted == ZIP_DATA_DESCRIPTOR_SIZE)
+					{
+						// the optional signature is present, so the descriptor is a bit longer
+						m_streamWanted += 4;
+					}
+					else
+					{
+						m_streamEntry.crc = ReadU32(m_streamBuffer.data() + (hasSignature ? 4 : 0));
+
+						EndStreamEntry();
+					}
+				}
+				break;
+			}
+			case StreamState::DONE:
+			case StreamState::FAILED:
+			{
+				break;
+			}
+		}
+	}
+}
 
-const char* MapExtractor::GetErrorString()
+void MapExtractor::BeginStreamEntry()
 {
-	return mz_zip_get_error_string(mz_zip_peek_last_error(&m_zip));
+	const char *header = m_streamBuffer.data();
+
+	if (ReadU32(header) != ZIP_LOCAL_HEADER_SIGNATURE)
+	{
+		// central directory, all local entries have been seen
+		m_streamState = StreamState::DONE;
+		return;
+	}
+
+	m_streamEntry.flags = ReadU16(header + 6);
+	m_streamEntry.method = ReadU16(header + 8);
+	m_streamEntry.crc = ReadU32(header + 14);
+	m_streamEntry.remainingSize = ReadU32(header + 18);
+	m_streamEntry.nameLength = ReadU16(header + 26);
+
+	m_streamEntry.hasher.init();
+
+	const uint32_t uncompressedSize = ReadU32(header + 22);
+	const uint16_t extraLength = ReadU16(header + 28);
+
+	const bool hasDescriptor = (m_streamEntry.flags & ZIP_FLAG_DATA_DESCRIPTOR);
+
+	if (m_streamEntry.flags & ZIP_FLAG_ENCRYPTED)
+	{
+		throw StringTools::ErrorFormat("Encrypted entry");
+	}
+
+	if (m_streamEntry.method != ZIP_METHOD_STORED && m_streamEntry.method != ZIP_METHOD_DEFLATED)
+	{
+		throw StringTools::ErrorFormat("Unsupported compression method %u", m_streamEntry.method);
+	}
+
+	if (hasDescriptor && m_streamEntry.method == ZIP_METHOD_STORED)
+	{
+		// the end of the data is not known
+		throw StringTools::ErrorFormat("Stored entry with data descriptor");
+	}
+
+	if (!hasDescriptor && (m_streamEntry.remainingSize == 0xFFFFFFFF || uncompressedSize == 0xFFFFFFFF))
+	{
+		throw StringTools::ErrorFormat("ZIP64 entry");
+	}
+
+	m_streamBuffer.clear();
+	m_streamWanted = m_streamEntry.nameLength + extraLength;
+	m_streamState = StreamState::NAME;
 }
 
-std::string MapExtractor::GetFileName(unsigned int index)
+void MapExtractor::OpenStreamEntry()
 {
-	char buffer[512];
-	if (!mz_zip_reader_get_filename(&m_zip, index, buffer, sizeof buffer))
+	m_streamEntry.name = m_streamBuffer.substr(0, m_streamEntry.nameLength);
+	m_streamEntry.currentCrc = static_cast<uint32_t>(mz_crc32(MZ_CRC32_INIT, nullptr, 0));
+
+	m_streamBuffer.clear();
+
+	const std::string & name = m_streamEntry.name;
+	const bool isDirectory = !name.empty() && (name.back() == '/' || name.back() == '\\');
+	const std::filesystem::path entryPath = name;
+
+	// files outside "levels/multiplayer/ps/mymap/" are only read through, Extract reports them
+	if (!isDirectory && Util::PathStartsWith(entryPath, m_mapPath))
 	{
-		throw StringTools::ErrorFormat("ZIP get filename: %s", GetErrorString());
+		const std::filesystem::path filePath = m_extractDir / entryPath;
+
+		std::filesystem::create_directories(filePath.parent_path());
+
+		if (!m_streamEntry.file.Open(filePath, WinAPI::FileAccess::WRITE_ONLY_CREATE))
+		{
+			throw StringTools::SysErrorFormat("Failed to open '%s'", filePath.string().c_str());
+		}
+
+		m_streamEntry.file.Resize(0);
 	}
 
-	return buffer;
+	if (m_streamEntry.method == ZIP_METHOD_DEFLATED)
+	{
+		tinfl_init(m_inflator.get());
+		m_dictOffset = 0;
+	}
+
+	m_streamState = StreamState::DATA;
+
+	if (m_streamEntry.remainingSize == 0 && !(m_streamEntry.flags & ZIP_FLAG_DATA_DESCRIPTOR))
+	{
+		EndStreamEntryData();
+	}
 }
 
-void MapExtractor::ExtractFile(unsigned int index)
+void MapExtractor::StreamEntryData(const mz_uint8 *& data, size_t & length)
 {
-	std::filesystem::path filePath = GetFileName(index);
+	const bool hasDescriptor = (m_streamEntry.flags & ZIP_FLAG_DATA_DESCRIPTOR);
+
+	size_t available = length;
+
+	if (!hasDescriptor && m_streamEntry.remainingSize < available)
+	{
+		available = static_cast<size_t>(m_streamEntry.remainingSize);
+	}
 
-	// skip files outside "levels/multiplayer/ps/mymap/"
-	if (!Util::PathStartsWith(filePath, m_mapPath))
+	if (m_streamEntry.method == ZIP_METHOD_STORED)
 	{
-		CryLogAlways("$6[CryMP] [MapExtractor] Ignoring '%s'", filePath.string().c_str());
+		WriteStreamEntry(data, available);
+
+		data += available;
+		length -= available;
+		m_streamEntry.remainingSize -= available;
+
+		if (m_streamEntry.remainingSize == 0)
+		{
+			EndStreamEntryData();
+		}
+
 		return;
 	}
 
-	filePath = m_dirPath / filePath;
+	const mz_uint8 *input = data;
+	size_t inputLength = available;
+	bool isDone = false;
+
+	while (true)
+	{
+		size_t inputSize = inputLength;
+		size_t outputSize = TINFL_LZ_DICT_SIZE - m_dictOffset;
 
-	std::filesystem::create_directories(filePath.parent_path());
+		// the dictionary is used as a circular output buffer
+		const tinfl_status status = tinfl_decompress(m_inflator.get(), input, &inputSize,
+		                                             m_dict.get(), m_dict.get() + m_dictOffset, &outputSize,
+		                                             TINFL_FLAG_HAS_MORE_INPUT);
 
-	if (!mz_zip_reader_extract_to_file(&m_zip, index, filePath.string().c_str(), 0))
+		input += inputSize;
+		inputLength -= inputSize;
+
+		if (outputSize > 0)
+		{
+			WriteStreamEntry(m_dict.get() + m_dictOffset, outputSize);
+
+			m_dictOffset = (m_dictOffset + outputSize) & (TINFL_LZ_DICT_SIZE - 1);
+		}
+
+		if (status == TINFL_STATUS_DONE)
+		{
+			isDone = true;
+			break;
+		}
+
+		if (status < 0)
+		{
+			throw StringTools::ErrorFormat("Inflate failed with status %d", static_cast<int>(status));
+		}
+
+		if (status == TINFL_STATUS_NEEDS_MORE_INPUT && inputLength == 0)
+		{
+			break;
+		}
+
+		if (inputSize == 0 && outputSize == 0)
+		{
+			throw StringTools::ErrorFormat("Inflate cannot make progress");
+		}
+	}
+
+	const size_t consumed = available - inputLength;
+
+	data += consumed;
+	length -= consumed;
+
+	if (!hasDescriptor)
+	{
+		m_streamEntry.remainingSize -= consumed;
+
+		if (isDone != (m_streamEntry.remainingSize == 0))
+		{
+			throw StringTools::ErrorFormat("Compressed size mismatch");
+		}
+	}
+
+	if (isDone)
 	{
-		throw StringTools::ErrorFormat("ZIP extract: %s", GetErrorString());
+		EndStreamEntryData();
 	}
 }
 
-MapExtractor::MapExtractor(const std::filesystem::path & zipPath, const std::filesystem::path & mapName)
+void MapExtractor::WriteStreamEntry(const mz_uint8 *data, size_t length)
 {
-	mz_zip_zero_struct(&m_zip);
+	m_streamEntry.currentCrc = static_cast<uint32_t>(mz_crc32(m_streamEntry.currentCrc, data, length));
 
-	if (!mz_zip_reader_init_file(&m_zip, zipPath.string().c_str(), 0))
+	if (m_streamEntry.file)
 	{
-		throw StringTools::ErrorFormat("ZIP open: %s", GetErrorString());
+		m_streamEntry.file.Write(std::string_view(reinterpret_cast<const char*>(data), length));
+		m_streamEntry.hasher.process(data, data + length);
 	}
+}
 
-	m_dirPath = zipPath.parent_path();
-	m_mapPath = "Levels" / mapName;
+void MapExtractor::EndStreamEntryData()
+{
+	if (m_streamEntry.flags & ZIP_FLAG_DATA_DESCRIPTOR)
+	{
+		m_streamBuffer.clear();
+		m_streamWanted = ZIP_DATA_DESCRIPTOR_SIZE;
+		m_streamState = StreamState::DESCRIPTOR;
+	}
+	else
+	{
+		EndStreamEntry();
+	}
+}
 
-	const std::filesystem::path mapDirPath = m_dirPath / m_mapPath;
+void MapExtractor::EndStreamEntry()
+{
+	const bool isExtracted = m_streamEntry.file.IsOpen();
 
-	if (std::filesystem::exists(mapDirPath))
+	m_streamEntry.file.Close();
+
+	if (m_streamEntry.currentCrc != m_streamEntry.crc)
+	{
+		throw StringTools::ErrorFormat("CRC mismatch in '%s'", m_streamEntry.name.c_str());
+	}
+	else if (isExtracted)
 	{
-		std::filesystem::remove_all(mapDirPath);
+		if (m_pStore)
+		{
+			m_streamEntry.hasher.finish();
+
+			m_pStore->Add(picosha2::get_hash_hex_string(m_streamEntry.hasher), m_extractDir / m_streamEntry.name);
+		}
+
+		m_streamedFiles.insert(m_streamEntry.name);
 	}
+
+	m_streamBuffer.clear();
+	m_streamWanted = ZIP_LOCAL_HEADER_SIZE;
+	m_streamState = StreamState::HEADER;
+}
+
+void MapExtractor::StopStream()
+{
+	// the current entry is extracted again from the complete file
+	m_streamEntry.file.Close();
+
+	if (m_streamState != StreamState::DONE)
+	{
+		m_streamState = StreamState::FAILED;
+	}
+}
+
+void MapExtractor::ExtractFiles(const std::vector<unsigned int> & indices, std::atomic<size_t> & next)
+{
+	// every thread needs its own reader
+	ZipReader zip(m_zipPath);
+
+	for (size_t i = next++; i < indices.size(); i = next++)
+	{
+		const unsigned int index = indices[i];
+		const std::filesystem::path filePath = m_extractDir / zip.GetFileName(index);
+
+		const std::string hash = zip.ExtractFile(index, filePath);
+
+		if (m_pStore)
+		{
+			m_pStore->Add(hash, filePath);
+		}
+	}
+}
+
+MapExtractor::MapExtractor(const std::filesystem::path & zipPath, const std::filesystem::path & mapName, MapStore *pStore)
+: m_pStore(pStore),
+  m_inflator(std::make_unique<tinfl_decompressor>()),
+  m_dict(std::make_unique<mz_uint8[]>(TINFL_LZ_DICT_SIZE))
+{
+	m_zipPath = zipPath;
+	m_dirPath = zipPath.parent_path();
+	m_extractDir = m_dirPath / "Extracting" / zipPath.stem();
+	m_mapPath = "Levels" / mapName;
+
+	m_streamWanted = ZIP_LOCAL_HEADER_SIZE;
+
+	// leftover of an interrupted extraction
+	std::filesystem::remove_all(m_extractDir);
 }
 
 MapExtractor::~MapExtractor()
 {
-	mz_zip_reader_end(&m_zip);
+}
+
+void MapExtractor::OnData(uint64_t offset, const char *data, size_t length)
+{
+	// only continuous data can be streamed, the rest is extracted from the complete file
+	if (offset != m_streamPosition)
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(m_streamMutex);
+
+	if (offset != m_streamPosition || m_streamState == StreamState::DONE || m_streamState == StreamState::FAILED)
+	{
+		return;
+	}
+
+	m_streamPosition += length;
+
+	try
+	{
+		Stream(reinterpret_cast<const mz_uint8*>(data), length);
+	}
+	catch (const std::exception & ex)
+	{
+		CryLog("$6[CryMP] [MapExtractor] Streaming stopped: %s", ex.what());
+
+		StopStream();
+	}
 }
 
 void MapExtractor::Extract()
 {
-	const unsigned int fileCount = mz_zip_reader_get_num_files(&m_zip);
+	{
+		std::lock_guard<std::mutex> lock(m_streamMutex);
+
+		StopStream();
+	}
+
+	ZipReader zip(m_zipPath);
+
+	std::vector<unsigned int> indices;
+
+	const unsigned int fileCount = zip.GetFileCount();
 
 	for (unsigned int index = 0; index < fileCount; index++)
 	{
-		if (!mz_zip_reader_is_file_a_directory(&m_zip, index))
+		if (zip.IsDirectory(index))
+		{
+			continue;
+		}
+
+		const std::string fileName = zip.GetFileName(index);
+
+		// skip files outside "levels/multiplayer/ps/mymap/"
+		if (!Util::PathStartsWith(fileName, m_mapPath))
+		{
+			CryLogAlways("$6[CryMP] [MapExtractor] Ignoring '%s'", fileName.c_str());
+			continue;
+		}
+
+		if (m_streamedFiles.count(fileName))
+		{
+			continue;
+		}
+
+		const std::filesystem::path filePath = m_extractDir / fileName;
+
+		std::filesystem::create_directories(filePath.parent_path());
+
+		indices.push_back(index);
+	}
+
+	CryLog("$3[CryMP] [MapExtractor] %zu files streamed, %zu files left",
+		m_streamedFiles.size(), indices.size());
+
+	if (!indices.empty())
+	{
+		ExtractRemainingFiles(indices);
+	}
+
+	ReplaceMap();
+}
+
+void MapExtractor::ExtractRemainingFiles(const std::vector<unsigned int> & indices)
+{
+	// spread the remaining entries across cores
+	const size_t threadCount = std::min<size_t>(WinAPI::GetLogicalProcessorCount(), indices.size());
+
+	std::atomic<size_t> next = 0;
+	std::vector<std::thread> threads;
+	std::vector<std::string> errors(threadCount);
+
+	for (size_t i = 0; i < threadCount; i++)
+	{
+		threads.emplace_back([this, &indices, &next, &error = errors[i]]()
+		{
+			try
+			{
+				ExtractFiles(indices, next);
+			}
+			catch (const std::exception & ex)
+			{
+				error = ex.what();
+
+				// stop the other threads
+				next = indices.size();
+			}
+		});
+	}
+
+	for (std::thread & thread : threads)
+	{
+		thread.join();
+	}
+
+	for (const std::string & error : errors)
+	{
+		if (!error.empty())
 		{
-			ExtractFile(index);
+			throw StringTools::ErrorFormat("%s", error.c_str());
 		}
 	}
 }
+
+void MapExtractor::ReplaceMap()
+{
+	const std::filesystem::path mapDirPath = m_dirPath / m_mapPath;
+	const std::filesystem::path extractedMapDirPath = m_extractDir / m_mapPath;
+
+	// the old map is removed only once the new one is complete
+	std::filesystem::remove_all(mapDirPath);
+
+	if (std::filesystem::exists(extractedMapDirPath))
+	{
+		std::filesystem::create_directories(mapDirPath.parent_path());
+		std::filesystem::rename(extractedMapDirPath, mapDirPath);
+	}
+
+	std::filesystem::remove_all(m_extractDir);
+}
+
+void MapExtractor::Abort()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_streamMutex);
+
+		StopStream();
+	}
+
+	// the installed map is kept
+	// no exceptions
+	std::error_code code;
+	std::filesystem::remove_all(m_extractDir, code);
+}
@@ -1,23 +1,86 @@
 #pragma once
 
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <set>
 #include <string>
+#include <vector>
 #include <filesystem>
 
 #include <miniz.h>
+#include <picosha2.h>
+
+#include "Library/WinAPI.h"
+
+class MapStore;
 
 class MapExtractor
 {
-	mz_zip_archive m_zip;
+	enum class StreamState
+	{
+		HEADER, NAME, DATA, DESCRIPTOR, DONE, FAILED
+	};
+
+	struct StreamEntry
+	{
+		std::string name;
+		WinAPI::File file;           // not open if the entry is skipped
+		uint16_t flags = 0;
+		uint16_t method = 0;
+		uint16_t nameLength = 0;
+		uint32_t crc = 0;            // from the local header or the data descriptor
+		uint32_t currentCrc = 0;
+		uint64_t remainingSize = 0;  // compressed bytes, unknown if there is a data descriptor
+		picosha2::hash256_one_by_one hasher;  // map store key
+	};
+
+	std::filesystem::path m_zipPath;
 	std::filesystem::path m_dirPath;
+	std::filesystem::path m_extractDir;  // the map is extracted here and moved to m_dirPath when complete
 	std::filesystem::path m_mapPath;
+	MapStore *m_pStore = nullptr;
 
-	const char* GetErrorString();
-	std::string GetFileName(unsigned int index);
-	void ExtractFile(unsigned int index);
+	// local file entries are extracted while the archive is being downloaded
+	std::mutex m_streamMutex;
+	std::atomic<uint64_t> m_streamPosition = 0;
+	StreamState m_streamState = StreamState::HEADER;
+	std::string m_streamBuffer;
+	size_t m_streamWanted = 0;
+	StreamEntry m_streamEntry;
+	std::unique_ptr<tinfl_decompressor> m_inflator;
+	std::unique_ptr<mz_uint8[]> m_dict;
+	size_t m_dictOffset = 0;
+	std::set<std::string> m_streamedFiles;
+
+	bool FillStreamBuffer(const mz_uint8 *& data, size_t & length);
+	void Stream(const mz_uint8 *data, size_t length);
+	void BeginStreamEntry();
+	void OpenStreamEntry();
+	void StreamEntryData(const mz_uint8 *& data, size_t & length);
+	void WriteStreamEntry(const mz_uint8 *data, size_t length);
+	void EndStreamEntryData();
+	void EndStreamEntry();
+	void StopStream();
+
+	void ExtractFiles(const std::vector<unsigned int> & indices, std::atomic<size_t> & next);
+	void ExtractRemainingFiles(const std::vector<unsigned int> & indices);
+	void ReplaceMap();
 
 public:
-	MapExtractor(const std::filesystem::path & zipPath, const std::filesystem::path & mapName);
+	// the existing map folder is replaced only when the extraction succeeds
+	// extracted files are linked to the same content in the store or added to it
+	MapExtractor(const std::filesystem::path & zipPath, const std::filesystem::path & mapName, MapStore *pStore = nullptr);
 	~MapExtractor();
 
+	// download threads, the data are expected to be written to the ZIP file already
+	void OnData(uint64_t offset, const char *data, size_t length);
+
+	// worker thread, extracts everything the stream did not from the complete ZIP file
+	// and then replaces the existing map folder
 	void Extract();
+
+	// removes the partially extracted map, the existing map folder is kept
+	void Abort();
 };
@@ -0,0 +1,87 @@
+#include "CryCommon/CrySystem/ISystem.h"
+
+#include "MapStore.h"
+
+std::filesystem::path MapStore::GetStorePath(const std::string & hash)
+{
+	// spread the files between subdirectories by the first hash byte
+	return m_storeDir / hash.substr(0, 2) / hash;
+}
+
+MapStore::MapStore(const std::filesystem::path & storeDir) : m_storeDir(storeDir)
+{
+	std::filesystem::create_directories(m_storeDir);
+}
+
+MapStore::~MapStore()
+{
+}
+
+void MapStore::Add(const std::string & hash, const std::filesystem::path & filePath)
+{
+	const std::filesystem::path storePath = GetStorePath(hash);
+
+	// no exceptions
+	std::error_code code;
+
+	std::filesystem::create_directories(storePath.parent_path(), code);
+
+	std::filesystem::create_hard_link(filePath, storePath, code);
+	if (!code)
+	{
+		// new content
+		return;
+	}
+
+	if (!std::filesystem::exists(storePath, code) || std::filesystem::equivalent(filePath, storePath, code))
+	{
+		// no hard links on this file system, the extracted file is kept as it is
+		return;
+	}
+
+	// the same content is already stored, so share it instead of keeping another copy
+	// the extracted file is replaced only if the link succeeds
+	std::filesystem::path linkPath = filePath;
+	linkPath += ".link";
+
+	std::filesystem::remove(linkPath, code);
+
+	std::filesystem::create_hard_link(storePath, linkPath, code);
+	if (code)
+	{
+		return;
+	}
+
+	std::filesystem::rename(linkPath, filePath, code);
+	if (code)
+	{
+		std::filesystem::remove(linkPath, code);
+	}
+}
+
+void MapStore::Cleanup()
+{
+	unsigned int removedCount = 0;
+
+	// no exceptions
+	std::error_code code;
+
+	for (const auto & entry : std::filesystem::recursive_directory_iterator(m_storeDir, code))
+	{
+		if (!entry.is_regular_file(code))
+		{
+			continue;
+		}
+
+		// the store link is the only one left
+		if (entry.hard_link_count(code) == 1 && std::filesystem::remove(entry.path(), code))
+		{
+			removedCount++;
+		}
+	}
+
+	if (removedCount > 0)
+	{
+		CryLog("$3[CryMP] [MapStore] Removed %u unused files", removedCount);
+	}
+}
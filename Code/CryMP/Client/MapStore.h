@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stdint.h>
+#include <filesystem>
+#include <string>
+
+// content-addressed storage of extracted map files shared by all downloaded maps
+// files are identified by SHA-256 of their content and hard-linked into the map folders
+class MapStore
+{
+	std::filesystem::path m_storeDir;
+
+	std::filesystem::path GetStorePath(const std::string & hash);
+
+public:
+	explicit MapStore(const std::filesystem::path & storeDir);
+	~MapStore();
+
+	// thread-safe, hash is SHA-256 of the extracted file in hex digits
+	// replaces the file with a link to the same stored content or stores it
+	void Add(const std::string & hash, const std::filesystem::path & filePath);
+
+	// removes content no longer used by any map
+	void Cleanup();
+};
@@ -1,4 +1,7 @@
+#include <algorithm>
+
 #include "CryCommon/CrySystem/ISystem.h"
+#include "CryCommon/CrySystem/ITimer.h"
 #include "CryCommon/CrySystem/IConsole.h"
 #include "CryCommon/CryEntitySystem/IEntitySystem.h"
 #include "CryCommon/Cry3DEngine/I3DEngine.h"
@@ -6,9 +9,258 @@
 #include "ParticleManager.h"
 #include "CryCommon/CryAction/IGameObject.h"
 
+static constexpr size_t SCAN_ENTITY_COUNT_PER_TICK = 32;
+static constexpr float RANK_INTERVAL = 0.25f;  // seconds, emitters near the budget limit should not flicker
+
 void ParticleManager::OnTick()
 {
+	if (gEnv->pSystem->IsDedicated())
+	{
+		return;
+	}
+
+	FUNCTION_PROFILER(gEnv->pSystem, PROFILE_GAME);
+
+	if (m_budget <= 0)
+	{
+		if (m_isBudgetApplied)
+		{
+			RestoreEmitters();
+		}
+
+		return;
+	}
+
+	IEntitySystem *pEntitySystem = gEnv->pEntitySystem;
+
+	// emitters are created and freed after spawn, so keep looking at a few entities per frame
+	const size_t scanCount = std::min(m_entities.size(), SCAN_ENTITY_COUNT_PER_TICK);
+
+	for (size_t i = 0; i < scanCount; i++)
+	{
+		if (m_nextScanPos >= m_entities.size())
+		{
+			m_nextScanPos = 0;
+		}
+
+		if (IEntity *pEntity = pEntitySystem->GetEntity(m_entities[m_nextScanPos]))
+		{
+			ScanEntity(pEntity);
+		}
+
+		m_nextScanPos++;
+	}
+
+	const float currentTime = gEnv->pTimer->GetCurrTime();
+
+	if (currentTime >= m_lastRankTime && currentTime - m_lastRankTime < RANK_INTERVAL)
+	{
+		return;
+	}
+
+	m_lastRankTime = currentTime;
+
+	ValidateEmitters();
+	RankEmitters();
+
+	// the closest visible ones run normally, the next visible ones are only drawn closer, the rest is paused
+	for (size_t rank = 0; rank < m_ranking.size(); rank++)
+	{
+		Emitter & emitter = m_emitters[m_ranking[rank]];
+
+		if (rank < static_cast<size_t>(m_budget))
+		{
+			SetEmitterState(emitter, EmitterState::NORMAL);
+		}
+		else if (rank < static_cast<size_t>(m_budget) * 2 && emitter.isVisible)
+		{
+			SetEmitterState(emitter, EmitterState::REDUCED);
+		}
+		else
+		{
+			SetEmitterState(emitter, EmitterState::PAUSED);
+		}
+	}
+
+	m_isBudgetApplied = true;
+}
+
+void ParticleManager::OnSpawn(IEntity *pEntity)
+{
+	const EntityId id = pEntity->GetId();
+
+	if (m_entityPositions.count(id))
+	{
+		// the ID has been reused without removal, e.g. after the entity system reset
+		OnRemove(pEntity);
+	}
+
+	m_entityPositions[id] = m_entities.size();
+	m_entities.push_back(id);
+
+	ScanEntity(pEntity);
+}
+
+void ParticleManager::OnRemove(IEntity *pEntity)
+{
+	const EntityId id = pEntity->GetId();
 
+	const auto it = m_entityPositions.find(id);
+	if (it == m_entityPositions.end())
+	{
+		return;
+	}
+
+	// swap with the last one to keep removal O(1)
+	const size_t pos = it->second;
+	const EntityId lastId = m_entities.back();
+	m_entities[pos] = lastId;
+	m_entities.pop_back();
+	m_entityPositions[lastId] = pos;
+	m_entityPositions.erase(id);
+
+	// the emitters go away with the entity
+	RemoveEmitters(id);
+}
+
+void ParticleManager::ScanEntity(IEntity *pEntity)
+{
+	const EntityId id = pEntity->GetId();
+	const int slotCount = pEntity->GetSlotCount();
+
+	for (int slot = 0; slot < slotCount; slot++)
+	{
+		IParticleEmitter *pEmitter = pEntity->GetParticleEmitter(slot);
+		if (!pEmitter)
+		{
+			continue;
+		}
+
+		const auto it = std::find_if(m_emitters.begin(), m_emitters.end(), [pEmitter](const Emitter & emitter)
+		{
+			return emitter.pEmitter == pEmitter;
+		});
+
+		if (it == m_emitters.end())
+		{
+			Emitter & emitter = m_emitters.emplace_back();
+			emitter.entityId = id;
+			emitter.slot = slot;
+			emitter.pEmitter = pEmitter;
+		}
+	}
+}
+
+void ParticleManager::RemoveEmitters(EntityId entityId)
+{
+	m_emitters.erase(std::remove_if(m_emitters.begin(), m_emitters.end(), [entityId](const Emitter & emitter)
+	{
+		return emitter.entityId == entityId;
+	}), m_emitters.end());
+}
+
+void ParticleManager::ValidateEmitters()
+{
+	IEntitySystem *pEntitySystem = gEnv->pEntitySystem;
+
+	// freed emitters must not be touched, so only the ones still in their slot are kept
+	m_emitters.erase(std::remove_if(m_emitters.begin(), m_emitters.end(), [pEntitySystem](const Emitter & emitter)
+	{
+		IEntity *pEntity = pEntitySystem->GetEntity(emitter.entityId);
+
+		return !pEntity || emitter.slot >= pEntity->GetSlotCount()
+		    || pEntity->GetParticleEmitter(emitter.slot) != emitter.pEmitter;
+	}), m_emitters.end());
+}
+
+void ParticleManager::RankEmitters()
+{
+	IEntitySystem *pEntitySystem = gEnv->pEntitySystem;
+	IGameFramework *pGameFramework = gEnv->pGame->GetIGameFramework();
+	const CCamera & camera = gEnv->pSystem->GetViewCamera();
+	const Vec3 cameraPos = camera.GetPosition();
+
+	m_ranking.clear();
+
+	for (size_t i = 0; i < m_emitters.size(); i++)
+	{
+		Emitter & emitter = m_emitters[i];
+
+		// finished emitters cost nothing, but the paused ones are still ranked to be resumed
+		if (emitter.state == EmitterState::NORMAL && !emitter.pEmitter->IsAlive())
+		{
+			continue;
+		}
+
+		emitter.distanceSq = (emitter.pEmitter->GetPos() - cameraPos).len2();
+
+		IGameObject *pGameObject = pGameFramework->GetGameObject(emitter.entityId);
+
+		if (pGameObject)
+		{
+			emitter.isVisible = pGameObject->IsProbablyVisible();
+		}
+		else
+		{
+			emitter.isVisible = camera.IsAABBVisible_F(emitter.pEmitter->GetBBox());
+		}
+
+		m_ranking.push_back(i);
+	}
+
+	std::sort(m_ranking.begin(), m_ranking.end(), [this](size_t a, size_t b)
+	{
+		const Emitter & emitterA = m_emitters[a];
+		const Emitter & emitterB = m_emitters[b];
+
+		if (emitterA.isVisible != emitterB.isVisible)
+		{
+			return emitterA.isVisible;
+		}
+
+		return emitterA.distanceSq < emitterB.distanceSq;
+	});
+}
+
+void ParticleManager::SetEmitterState(Emitter & emitter, EmitterState state)
+{
+	if (emitter.state == state)
+	{
+		return;
+	}
+
+	if (emitter.state == EmitterState::PAUSED)
+	{
+		emitter.pEmitter->Activate(true);
+	}
+	else if (emitter.state == EmitterState::REDUCED)
+	{
+		emitter.pEmitter->SetViewDistRatio(emitter.viewDistRatio);
+	}
+
+	if (state == EmitterState::PAUSED)
+	{
+		emitter.pEmitter->Activate(false);
+	}
+	else if (state == EmitterState::REDUCED)
+	{
+		emitter.viewDistRatio = emitter.pEmitter->GetViewDistRatio();
+		emitter.pEmitter->SetViewDistRatio(std::min(m_reducedViewDistRatio, emitter.viewDistRatio));
+	}
+
+	emitter.state = state;
+}
+
+void ParticleManager::RestoreEmitters()
+{
+	ValidateEmitters();
+
+	for (Emitter & emitter : m_emitters)
+	{
+		SetEmitterState(emitter, EmitterState::NORMAL);
+	}
+
+	m_isBudgetApplied = false;
 }
 
 void ParticleManager::CmdListEmitters(IConsoleCmdArgs* pArgs)
@@ -61,9 +313,27 @@ ParticleManager::ParticleManager()
 	IConsole* pConsole = gEnv->pConsole;
 
 	pConsole->AddCommand("emitters", CmdListEmitters, 0, "List particle emitters");
+
+	pConsole->Register("cl_particleEmitterBudget", &m_budget, 48, VF_NOT_NET_SYNCED,
+		"Number of entity particle emitters running normally, 0 disables the budget.\n"
+		"Emitters are ranked by visibility and distance. Up to the same number of visible ones\n"
+		"over the budget are drawn only at a shorter distance, the rest is paused.");
+	pConsole->Register("cl_particleEmitterViewDistRatio", &m_reducedViewDistRatio, 30, VF_NOT_NET_SYNCED,
+		"View distance ratio of visible particle emitters over the budget.");
+
+	// entities spawned before the sink was registered
+	IEntityItPtr pIt = gEnv->pEntitySystem->GetEntityIterator();
+
+	while (IEntity *pEntity = pIt->Next())
+	{
+		OnSpawn(pEntity);
+	}
 }
 
 ParticleManager::~ParticleManager()
 {
+	IConsole* pConsole = gEnv->pConsole;
+	pConsole->UnregisterVariable("cl_particleEmitterBudget", true);
+	pConsole->UnregisterVariable("cl_particleEmitterViewDistRatio", true);
 }
 
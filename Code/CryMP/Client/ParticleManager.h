@@ -1,17 +1,61 @@
 #pragma once
 
+#include <unordered_map>
+#include <vector>
+
+#include "CryCommon/CryEntitySystem/IEntitySystem.h"
+
+struct IConsoleCmdArgs;
+struct IParticleEmitter;
+
+// keeps the number of entity particle emitters within a per-frame budget
+// spawn and removal come from the entity system sink in Client, the slots of a few entities are rescanned per frame
 class ParticleManager
 {
+	enum class EmitterState
+	{
+		NORMAL, REDUCED, PAUSED
+	};
 
+	struct Emitter
+	{
+		EntityId entityId = 0;
+		int slot = 0;
+		IParticleEmitter *pEmitter = nullptr;
+		int viewDistRatio = 0;  // the original one while reduced
+		float distanceSq = 0;
+		bool isVisible = false;
+		EmitterState state = EmitterState::NORMAL;
+	};
 
-public:
+	std::vector<EntityId> m_entities;
+	std::unordered_map<EntityId, size_t> m_entityPositions;
+	size_t m_nextScanPos = 0;
 
-	void OnTick();
+	std::vector<Emitter> m_emitters;
+	std::vector<size_t> m_ranking;
+	float m_lastRankTime = 0;
+	bool m_isBudgetApplied = false;
 
-	static void CmdListEmitters(IConsoleCmdArgs* pArgs);
-	static void CmdListAttachments(IConsoleCmdArgs* pArgs);
+	int m_budget = 0;
+	int m_reducedViewDistRatio = 0;
+
+	void ScanEntity(IEntity *pEntity);
+	void RemoveEmitters(EntityId entityId);
+	void ValidateEmitters();
+	void RankEmitters();
+	void SetEmitterState(Emitter & emitter, EmitterState state);
+	void RestoreEmitters();
+
+public:
 	ParticleManager();
 	~ParticleManager();
 
+	void OnTick();
 
+	void OnSpawn(IEntity *pEntity);
+	void OnRemove(IEntity *pEntity);
+
+	static void CmdListEmitters(IConsoleCmdArgs* pArgs);
+	static void CmdListAttachments(IConsoleCmdArgs* pArgs);
 };
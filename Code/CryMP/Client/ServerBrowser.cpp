@@ -5,6 +5,7 @@
 #include <nlohmann/json.hpp>
 
 #include "CryCommon/CrySystem/ISystem.h"
+#include "CryMP/Common/Executor.h"
 #include "Library/StringTools.h"
 #include "Library/Util.h"
 
@@ -119,37 +120,62 @@ namespace
 		server.FixPakUrl();
 	}
 
-	void SetBasicServerInfo(IServerListener *pListener, const json & serverInfo, int serverID, bool isUpdate)
+	template<class BasicInfo>
+	void ParseBasicInfo(const json & serverInfo, BasicInfo & info)
 	{
-		SBasicServerInfo info = {};
-
-		info.m_hostName   =              GetCString(serverInfo, "name");
-		info.m_mapName    =              GetCString(serverInfo, "mapnm");
-		info.m_numPlayers =                  GetInt(serverInfo, "numpl");
-		info.m_maxPlayers =                  GetInt(serverInfo, "maxpl");
-		info.m_publicIP   = IPFromString(GetCString(serverInfo, "public_ip"));
-		info.m_privateIP  = IPFromString(GetCString(serverInfo, "local_ip"));
-		info.m_publicPort =                  GetInt(serverInfo, "public_port");
-		info.m_hostPort   =                  GetInt(serverInfo, "local_port");
-		info.m_official   =                  GetInt(serverInfo, "ranked") != 0;
-		info.m_private    =               GetString(serverInfo, "pass") != "0";
+		info.hostName   =                 GetString(serverInfo, "name");
+		info.mapName    =                 GetString(serverInfo, "mapnm");
+		info.numPlayers =                    GetInt(serverInfo, "numpl");
+		info.maxPlayers =                    GetInt(serverInfo, "maxpl");
+		info.publicIP   =   IPFromString(GetCString(serverInfo, "public_ip"));
+		info.privateIP  =   IPFromString(GetCString(serverInfo, "local_ip"));
+		info.publicPort =                    GetInt(serverInfo, "public_port");
+		info.hostPort   =                    GetInt(serverInfo, "local_port");
+		info.official   =                    GetInt(serverInfo, "ranked") != 0;
+		info.isPrivate  =                 GetString(serverInfo, "pass") != "0";
 
-		const std::string version = "1.1.1." + std::to_string(GetInt(serverInfo, "ver"));
-		info.m_gameVersion = version.c_str();
+		info.gameVersion = "1.1.1." + std::to_string(GetInt(serverInfo, "ver"));
 
-		info.m_gameType = GetGameType(serverInfo);
+		info.gameType = GetGameType(serverInfo);
 
 		if (GetBool(serverInfo, "gs"))
 		{
-			info.m_mapName      = GetCString(serverInfo, "mapdnm");
-			info.m_anticheat    =    GetBool(serverInfo, "anticheat");
-			info.m_dedicated    =    GetBool(serverInfo, "dedicated");
-			info.m_dx10         =    GetBool(serverInfo, "dx10");
-			info.m_friendlyfire =    GetBool(serverInfo, "friendlyfire");
-			info.m_gamepadsonly =    GetBool(serverInfo, "gamepadsonly");
-			info.m_voicecomm    =    GetBool(serverInfo, "voicecomm");
+			info.mapName      = GetString(serverInfo, "mapdnm");
+			info.anticheat    =   GetBool(serverInfo, "anticheat");
+			info.dedicated    =   GetBool(serverInfo, "dedicated");
+			info.dx10         =   GetBool(serverInfo, "dx10");
+			info.friendlyfire =   GetBool(serverInfo, "friendlyfire");
+			info.gamepadsonly =   GetBool(serverInfo, "gamepadsonly");
+			info.voicecomm    =   GetBool(serverInfo, "voicecomm");
 		}
 
+		info.connectable = GetInt(serverInfo, "available") != 0;
+	}
+
+	template<class BasicInfo>
+	void SetBasicServerInfo(IServerListener *pListener, const BasicInfo & basicInfo, int serverID, bool isUpdate)
+	{
+		SBasicServerInfo info = {};
+
+		info.m_hostName     = basicInfo.hostName.c_str();
+		info.m_mapName      = basicInfo.mapName.c_str();
+		info.m_numPlayers   = basicInfo.numPlayers;
+		info.m_maxPlayers   = basicInfo.maxPlayers;
+		info.m_publicIP     = basicInfo.publicIP;
+		info.m_privateIP    = basicInfo.privateIP;
+		info.m_publicPort   = basicInfo.publicPort;
+		info.m_hostPort     = basicInfo.hostPort;
+		info.m_official     = basicInfo.official;
+		info.m_private      = basicInfo.isPrivate;
+		info.m_gameVersion  = basicInfo.gameVersion.c_str();
+		info.m_gameType     = basicInfo.gameType;
+		info.m_anticheat    = basicInfo.anticheat;
+		info.m_dedicated    = basicInfo.dedicated;
+		info.m_dx10         = basicInfo.dx10;
+		info.m_friendlyfire = basicInfo.friendlyfire;
+		info.m_gamepadsonly = basicInfo.gamepadsonly;
+		info.m_voicecomm    = basicInfo.voicecomm;
+
 		// not used
 		info.m_country = "";
 
@@ -163,7 +189,7 @@ namespace
 			pListener->NewServer(serverID, &info);
 
 		// custom stuff
-		pListener->UpdateValue(serverID, "connectable", GetInt(serverInfo, "available") ? "1" : "0");
+		pListener->UpdateValue(serverID, "connectable", basicInfo.connectable ? "1" : "0");
 	}
 }
 
@@ -191,39 +217,116 @@ bool ServerBrowser::OnPublicAddress(HTTPClientResult & result)
 	return true;
 }
 
-bool ServerBrowser::OnServerList(HTTPClientResult & result, const std::string & master)
+void ServerBrowser::ParseServerList(ServerList & list)
 {
-	CryLog("[CryMP] Server list (%d): %s", result.code, result.response.c_str());
-
 	try
 	{
-		const json serverList = json::parse(result.response);
+		const json serverList = json::parse(list.response);
 
 		if (serverList.contains("error"))
 		{
-			CryLogAlways("$4[CryMP] Server list update error: %s", GetCString(serverList, "error"));
-			return false;
+			list.error = StringTools::Format("Server list update error: %s", GetCString(serverList, "error"));
+			return;
 		}
 
+		list.servers.reserve(serverList.size());
+
 		for (const json & serverInfo : serverList)
 		{
-			const int serverID = static_cast<int>(m_servers.size());
+			Server& server = list.servers.emplace_back();
+			ParseServerInfo(serverInfo, server.info);
+			ParseBasicInfo(serverInfo, server.basic);
+			server.info.master = list.master;
+			server.info.is_local = server.info.public_host == list.clientPublicAddress;
+			server.endpoint = server.info.public_host + ':' + std::to_string(server.info.public_port);
+		}
+	}
+	catch (const json::exception & ex)
+	{
+		list.error = StringTools::Format("Server list parse error: %s", ex.what());
+	}
+}
 
-			ServerInfo& server = m_servers.emplace_back();
-			ParseServerInfo(serverInfo, server);
-			server.master = master;
-			server.is_local = server.public_host == m_clientPublicAddress;
+void ServerBrowser::OnServerList(ServerList & list)
+{
+	if (!list.error.empty())
+	{
+		CryLogAlways("$4[CryMP] %s", list.error.c_str());
+		return;
+	}
+
+	for (Server & server : list.servers)
+	{
+		const auto [it, isNew] = m_serverIDs.try_emplace(server.endpoint, static_cast<int>(m_servers.size()));
+		const int serverID = it->second;
+
+		if (isNew)
+		{
+			m_servers.emplace_back().endpoint = std::move(server.endpoint);
+		}
+
+		Server& existing = m_servers[serverID];
 
-			SetBasicServerInfo(m_pListener, serverInfo, serverID, false);
+		if (existing.isListed && existing.contract == m_contract)
+		{
+			// already reported by another master
+			continue;
+		}
+
+		const bool wasListed = existing.isListed;
+		const bool isChanged = !wasListed || !(existing.basic == server.basic);
+
+		existing.info = std::move(server.info);
+		existing.contract = m_contract;
+		existing.isListed = true;
+
+		if (isChanged)
+		{
+			existing.basic = std::move(server.basic);
+
+			SetBasicServerInfo(m_pListener, existing.basic, serverID, wasListed);
+		}
+
+		if (!wasListed)
+		{
+			m_listedServerCount++;
 		}
 	}
-	catch (const json::exception & ex)
+}
+
+void ServerBrowser::OnServerListDone()
+{
+	m_pendingQueryCount--;
+
+	if (m_pendingQueryCount == 0 && m_pListener)
 	{
-		CryLogAlways("$4[CryMP] Server list parse error: %s", ex.what());
-		return false;
+		RemoveUnlistedServers();
+
+		m_pListener->UpdateComplete(false);
 	}
+}
 
-	return true;
+void ServerBrowser::RemoveUnlistedServers()
+{
+	for (int serverID = 0; serverID < static_cast<int>(m_servers.size()); serverID++)
+	{
+		Server& server = m_servers[serverID];
+
+		if (server.isListed && server.contract != m_contract)
+		{
+			server.isListed = false;
+			m_listedServerCount--;
+
+			m_pListener->RemoveServer(serverID);
+		}
+	}
+}
+
+void ServerBrowser::ClearServers()
+{
+	m_servers.clear();
+	m_serverIDs.clear();
+	m_listedServerCount = 0;
 }
 
 bool ServerBrowser::OnServerInfo(HTTPClientResult & result, int serverID)
@@ -240,9 +343,11 @@ bool ServerBrowser::OnServerInfo(HTTPClientResult & result, int serverID)
 			return false;
 		}
 
-		ParseServerInfo(serverInfo, m_servers[serverID]);
+		Server& server = m_servers[serverID];
+		ParseServerInfo(serverInfo, server.info);
+		ParseBasicInfo(serverInfo, server.basic);
 
-		SetBasicServerInfo(m_pListener, serverInfo, serverID, true);
+		SetBasicServerInfo(m_pListener, server.basic, serverID, true);
 
 		m_pListener->UpdateValue(serverID, "hostname",              GetCString(serverInfo, "name"));
 		m_pListener->UpdateValue(serverID, "mapname",               GetCString(serverInfo, "mapnm"));
@@ -329,17 +434,25 @@ void ServerBrowser::Start(bool browseLAN)
 
 void ServerBrowser::SetListener(IServerListener *pListener)
 {
+	if (pListener != m_pListener)
+	{
+		// the new listener knows nothing about the servers
+		Stop();
+		ClearServers();
+	}
+
 	m_pListener = pListener;
 }
 
 void ServerBrowser::Stop()
 {
-	m_servers.clear();
+	// drop pending replies, the listed servers are kept to be updated by the next refresh
+	m_contract++;
+	m_pendingQueryCount = 0;
 }
 
 void ServerBrowser::Update()
 {
-	m_servers.clear();
 	m_pendingQueryCount = static_cast<unsigned int>(gClient->GetMasters().size());
 
 	int contractId = ++m_contract;
@@ -355,41 +468,64 @@ void ServerBrowser::Update()
 				return;
 			}
 
-			m_pendingQueryCount--;
-
 			const bool success = result.error.empty();
 			m_lastRequestSucceeded = success;
 
-			if (m_pListener)
+			if (!success || !m_pListener)
 			{
-				if (success)
-				{
-					OnServerList(result, master);
-				}
-				else
+				if (!success)
 				{
 					CryLogAlways("$4[CryMP] Server list update failed: %s", result.error.c_str());
 				}
 
-				if (m_pendingQueryCount == 0)
+				OnServerListDone();
+				return;
+			}
+
+			CryLog("[CryMP] Server list (%d): %s", result.code, result.response.c_str());
+
+			auto list = std::make_shared<ServerList>();
+			list->master = master;
+			list->response = std::move(result.response);
+			list->clientPublicAddress = m_clientPublicAddress;
+
+			// the JSON is parsed on a worker, the main thread only applies the changes
+			gClient->GetExecutor()->RunAsync(
+				[list]()
+				{
+					ParseServerList(*list);
+				},
+				[this, list, contractId]()
 				{
-					m_pListener->UpdateComplete(false);
+					if (contractId != m_contract)
+					{
+						return;
+					}
+
+					if (m_pListener)
+					{
+						OnServerList(*list);
+					}
+
+					OnServerListDone();
 				}
-			}
+			);
 		});
 	}
 }
 
 void ServerBrowser::UpdateServerInfo(int id)
 {
-	if (id < 0 || id >= m_servers.size())
+	if (!IsListed(id))
 	{
 		return;
 	}
 
-	const std::string url = gClient->GetMasterServerAPI(m_servers[id].master)
-		+ "/server?ip=" + m_servers[id].public_host
-		+ "&port=" + std::to_string(m_servers[id].public_port)
+	const ServerInfo& server = m_servers[id].info;
+
+	const std::string url = gClient->GetMasterServerAPI(server.master)
+		+ "/server?ip=" + server.public_host
+		+ "&port=" + std::to_string(server.public_port)
 		+ "&json";
 
 	gClient->HttpGet(url, [id, this](HTTPClientResult& result)
@@ -397,7 +533,7 @@ void ServerBrowser::UpdateServerInfo(int id)
 		const bool success = result.error.empty();
 		m_lastRequestSucceeded = success;
 
-		if (m_pListener)
+		if (m_pListener && IsListed(id))
 		{
 			if (success)
 			{
@@ -432,17 +568,17 @@ void ServerBrowser::SendNatCookie(unsigned int ip, unsigned short port, int cook
 
 void ServerBrowser::CheckDirectConnect(int id, unsigned short port)
 {
-	if (id < 0 || id >= m_servers.size())
+	if (!IsListed(id))
 	{
 		return;
 	}
 
-	gClient->GetServerConnector()->Connect(m_servers[id]);
+	gClient->GetServerConnector()->Connect(m_servers[id].info);
 }
 
 int ServerBrowser::GetServerCount()
 {
-	return m_servers.size();
+	return m_listedServerCount;
 }
 
 int ServerBrowser::GetPendingQueryCount()
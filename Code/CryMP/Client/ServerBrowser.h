@@ -1,6 +1,9 @@
 #pragma once
 
+#include <stdint.h>
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "CryCommon/CryNetwork/INetworkService.h"
@@ -11,9 +14,57 @@ struct HTTPClientResult;
 
 class ServerBrowser : public IServerBrowser
 {
+	// what the listener gets in SBasicServerInfo
+	struct BasicInfo
+	{
+		std::string hostName;
+		std::string mapName;
+		std::string gameVersion;
+		const char *gameType = "";
+		int numPlayers = 0;
+		int maxPlayers = 0;
+		uint32_t publicIP = 0;
+		uint32_t privateIP = 0;
+		unsigned short publicPort = 0;
+		unsigned short hostPort = 0;
+		bool official = false;
+		bool isPrivate = false;
+		bool anticheat = false;
+		bool dedicated = false;
+		bool dx10 = false;
+		bool friendlyfire = false;
+		bool gamepadsonly = false;
+		bool voicecomm = false;
+		bool connectable = false;
+
+		bool operator==(const BasicInfo &) const = default;
+	};
+
+	struct Server
+	{
+		std::string endpoint;
+		ServerInfo info;
+		BasicInfo basic;
+		unsigned int contract = 0;  // the last server list update reporting the server
+		bool isListed = false;      // known by the listener
+	};
+
+	// one master's reply, parsed on a worker thread
+	struct ServerList
+	{
+		std::string master;
+		std::string response;
+		std::string clientPublicAddress;
+		std::string error;
+		std::vector<Server> servers;
+	};
+
 	std::string m_clientPublicAddress;
 
-	std::vector<ServerInfo> m_servers;
+	// server IDs stay the same across updates, so only changes are reported to the listener
+	std::vector<Server> m_servers;
+	std::unordered_map<std::string, int> m_serverIDs;
+	unsigned int m_listedServerCount = 0;
 	IServerListener *m_pListener = nullptr;
 
 	unsigned int m_pendingQueryCount = 0;
@@ -21,9 +72,20 @@ class ServerBrowser : public IServerBrowser
 	bool m_lastRequestSucceeded = false;
 
 	bool OnPublicAddress(HTTPClientResult & result);
-	bool OnServerList(HTTPClientResult & result, const std::string & master);
+	void OnServerList(ServerList & list);
+	void OnServerListDone();
 	bool OnServerInfo(HTTPClientResult & result, int serverID);
 
+	static void ParseServerList(ServerList & list);
+
+	void RemoveUnlistedServers();
+	void ClearServers();
+
+	bool IsListed(int serverID) const
+	{
+		return serverID >= 0 && serverID < static_cast<int>(m_servers.size()) && m_servers[serverID].isListed;
+	}
+
 public:
 	ServerBrowser();
 	~ServerBrowser();
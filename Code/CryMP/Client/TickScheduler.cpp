@@ -0,0 +1,245 @@
+#include <algorithm>
+#include <thread>
+
+#include "CryCommon/CrySystem/ISystem.h"
+#include "CryCommon/CrySystem/IConsole.h"
+#include "Library/WinAPI.h"
+
+#include "Client.h"
+#include "TickScheduler.h"
+
+namespace
+{
+	template<class Duration>
+	double ToMilliseconds(Duration duration)
+	{
+		return std::chrono::duration<double, std::milli>(duration).count();
+	}
+}
+
+void TickScheduler::Histogram::Add(double value)
+{
+	const auto it = std::lower_bound(BOUNDS.begin(), BOUNDS.end(), value);
+
+	counts[it - BOUNDS.begin()]++;
+	total++;
+	sum += value;
+	max = std::max(max, value);
+}
+
+void TickScheduler::Histogram::Log(const char *name, uint64_t tickCount) const
+{
+	const double mean = (total > 0) ? sum / total : 0;
+
+	CryLogAlways("%s: %llu of %llu ticks, mean %.3f ms, max %.3f ms", name, total, tickCount, mean, max);
+
+	for (size_t i = 0; i < counts.size(); i++)
+	{
+		if (counts[i] == 0)
+		{
+			continue;
+		}
+
+		const double percent = (100.0 * counts[i]) / total;
+
+		if (i < BOUNDS.size())
+		{
+			CryLogAlways("  <= %6.2f ms: %10llu (%5.1f%%)", BOUNDS[i], counts[i], percent);
+		}
+		else
+		{
+			CryLogAlways("   > %6.2f ms: %10llu (%5.1f%%)", BOUNDS.back(), counts[i], percent);
+		}
+	}
+}
+
+TickScheduler::TickScheduler()
+{
+	m_hTimer = WinAPI::WaitableTimerCreate();
+	if (!m_hTimer)
+	{
+		CryLogWarning("TickScheduler: High-resolution timer is not available, waiting by Sleep");
+	}
+
+	IConsole *pConsole = gEnv->pConsole;
+
+	pConsole->Register("sv_tickRate", &m_tickRate, 0, VF_NOT_NET_SYNCED,
+		"Target number of server ticks per second while hosting a multiplayer game, 0 means unlimited.\n"
+		"The server runs in the frame loop, so this also limits the frame rate of the host.");
+	pConsole->Register("sv_tickSpinTime", &m_spinTime, 1.0f, VF_NOT_NET_SYNCED,
+		"Milliseconds before the next tick spent spinning instead of sleeping for accuracy.");
+
+	pConsole->AddCommand("sv_tickStats", OnTickStatsCmd, VF_NOT_NET_SYNCED, "Usage: sv_tickStats [reset]");
+}
+
+TickScheduler::~TickScheduler()
+{
+	IConsole *pConsole = gEnv->pConsole;
+	pConsole->RemoveCommand("sv_tickStats");
+	pConsole->UnregisterVariable("sv_tickRate", true);
+	pConsole->UnregisterVariable("sv_tickSpinTime", true);
+
+	if (m_hTimer)
+	{
+		WinAPI::WaitableTimerClose(m_hTimer);
+	}
+
+	SetHighTimerResolution(false);
+}
+
+void TickScheduler::SetHighTimerResolution(bool enable)
+{
+	// only needed by Sleep, which has the system timer resolution, 15.6 ms by default
+	if (enable && !m_hasTimerResolution && !m_hTimer)
+	{
+		m_hasTimerResolution = WinAPI::TimerResolutionBegin(1);
+	}
+	else if (!enable && m_hasTimerResolution)
+	{
+		WinAPI::TimerResolutionEnd(1);
+		m_hasTimerResolution = false;
+	}
+}
+
+void TickScheduler::SleepUntil(Clock::time_point deadline)
+{
+	const auto spinTime = std::chrono::duration_cast<Clock::duration>(
+		std::chrono::duration<float, std::milli>(std::max(m_spinTime, 0.0f))
+	);
+
+	Clock::duration remaining;
+
+	while ((remaining = deadline - Clock::now()) > Clock::duration::zero())
+	{
+		// both ways of sleeping wake up slightly late, so the rest is spent spinning
+		if (remaining > spinTime)
+		{
+			if (m_hTimer)
+			{
+				const auto sleepTime = std::chrono::duration_cast<std::chrono::microseconds>(remaining - spinTime);
+
+				if (sleepTime.count() > 0 && WinAPI::WaitableTimerWait(m_hTimer, sleepTime.count()))
+				{
+					continue;
+				}
+			}
+			else
+			{
+				const auto sleepTime = std::chrono::duration_cast<std::chrono::milliseconds>(remaining - spinTime);
+
+				if (sleepTime.count() > 0)
+				{
+					WinAPI::Sleep(static_cast<unsigned int>(sleepTime.count()));
+					continue;
+				}
+			}
+		}
+
+		std::this_thread::yield();
+	}
+}
+
+void TickScheduler::Wait()
+{
+	const Clock::time_point now = Clock::now();
+
+	if (m_tickRate <= 0)
+	{
+		Stop();
+		return;
+	}
+
+	SetHighTimerResolution(true);
+
+	const auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / m_tickRate));
+
+	bool isResync = true;
+
+	if (m_isRunning)
+	{
+		m_tickCount++;
+
+		const Clock::duration workTime = now - m_tickStart;
+		if (workTime > period)
+		{
+			m_overrun.Add(ToMilliseconds(workTime - period));
+		}
+
+		m_deadline += period;
+
+		// more than one period behind, do not try to catch up with a burst of ticks
+		if (now - m_deadline > period)
+		{
+			m_resyncCount++;
+		}
+		else
+		{
+			isResync = false;
+		}
+	}
+
+	if (isResync)
+	{
+		m_deadline = now;
+		m_isRunning = true;
+	}
+
+	SleepUntil(m_deadline);
+
+	m_tickStart = Clock::now();
+
+	if (!isResync)
+	{
+		m_jitter.Add(ToMilliseconds(m_tickStart - m_deadline));
+	}
+}
+
+void TickScheduler::Stop()
+{
+	m_isRunning = false;
+
+	SetHighTimerResolution(false);
+}
+
+void TickScheduler::LogStats() const
+{
+	if (m_tickRate > 0)
+	{
+		CryLogAlways("[CryMP] Tick rate %d Hz, %s wait, %llu ticks, %llu resyncs",
+			m_tickRate, m_hTimer ? "timer" : "sleep", m_tickCount, m_resyncCount);
+	}
+	else
+	{
+		CryLogAlways("[CryMP] Tick rate unlimited, %llu ticks, %llu resyncs", m_tickCount, m_resyncCount);
+	}
+
+	m_overrun.Log("Overrun", m_tickCount);
+	m_jitter.Log("Jitter", m_tickCount);
+}
+
+void TickScheduler::ResetStats()
+{
+	m_tickCount = 0;
+	m_resyncCount = 0;
+	m_overrun = Histogram();
+	m_jitter = Histogram();
+}
+
+void TickScheduler::OnTickStatsCmd(IConsoleCmdArgs *pArgs)
+{
+	TickScheduler *pTickScheduler = gClient ? gClient->GetTickScheduler() : nullptr;
+	if (!pTickScheduler)
+	{
+		return;
+	}
+
+	if (pArgs->GetArgCount() > 1 && _stricmp(pArgs->GetArg(1), "reset") == 0)
+	{
+		pTickScheduler->ResetStats();
+		CryLogAlways("[CryMP] Tick statistics reset");
+	}
+	else
+	{
+		pTickScheduler->LogStats();
+	}
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+struct IConsoleCmdArgs;
+
+class TickScheduler
+{
+	using Clock = std::chrono::steady_clock;
+
+	struct Histogram
+	{
+		// upper bounds of the buckets in milliseconds, the last bucket has no limit
+		static constexpr std::array<float, 9> BOUNDS = { 0.1f, 0.25f, 0.5f, 1, 2, 5, 10, 20, 50 };
+
+		std::array<uint64_t, BOUNDS.size() + 1> counts = {};
+		uint64_t total = 0;
+		double sum = 0;
+		double max = 0;
+
+		void Add(double value);
+		void Log(const char *name, uint64_t tickCount) const;
+	};
+
+	void *m_hTimer = nullptr;  // null if high-resolution timers are not supported
+	bool m_hasTimerResolution = false;  // raised for Sleep while pacing without a timer
+
+	Clock::time_point m_deadline;
+	Clock::time_point m_tickStart;
+	bool m_isRunning = false;
+
+	uint64_t m_tickCount = 0;
+	uint64_t m_resyncCount = 0;
+	Histogram m_overrun;  // work time over the tick period
+	Histogram m_jitter;   // tick start after the deadline
+
+	int m_tickRate = 0;
+	float m_spinTime = 0;  // milliseconds
+
+	void SetHighTimerResolution(bool enable);
+	void SleepUntil(Clock::time_point deadline);
+
+	static void OnTickStatsCmd(IConsoleCmdArgs *pArgs);
+
+public:
+	TickScheduler();
+	~TickScheduler();
+
+	// main thread, blocks until the next tick should start
+	void Wait();
+	// no ticks are paced until the next Wait, which starts over without counting a resync
+	void Stop();
+
+	void LogStats() const;
+	void ResetStats();
+};
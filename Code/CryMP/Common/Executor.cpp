@@ -1,3 +1,10 @@
+#include <algorithm>
+#include <chrono>
+
+#include "CryCommon/CrySystem/ISystem.h"
+#include "CryCommon/CrySystem/IConsole.h"
+#include "Library/WinAPI.h"
+
 #include "Executor.h"
 
 void ExecutorTaskQueue::Push(std::unique_ptr<IExecutorTask> && task)
@@ -22,20 +29,28 @@ std::unique_ptr<IExecutorTask> ExecutorTaskQueue::Pop()
 	return task;
 }
 
-std::unique_ptr<IExecutorTask> ExecutorTaskQueue::PopWait(std::condition_variable & cv)
+std::unique_ptr<IExecutorTask> Executor::PopWorkerTask(ExecutorLane & lane)
 {
-	std::unique_lock<std::mutex> lock(m_mutex);
+	// the caller holds m_workerMutex
+
+	auto & interactiveQueue = m_workerQueues[static_cast<int>(ExecutorLane::INTERACTIVE)];
+	auto & bulkQueue = m_workerQueues[static_cast<int>(ExecutorLane::BULK)];
 
 	std::unique_ptr<IExecutorTask> task;
 
-	if (!m_queue.empty())
+	if (!interactiveQueue.empty())
 	{
-		task = std::move(m_queue.front());
-		m_queue.pop_front();
+		task = std::move(interactiveQueue.front());
+		interactiveQueue.pop_front();
+		lane = ExecutorLane::INTERACTIVE;
 	}
-	else
+	else if (!bulkQueue.empty() && m_activeBulkTasks < m_maxBulkTasks)
 	{
-		cv.wait(lock);
+		// at least one worker always stays available for interactive tasks
+		task = std::move(bulkQueue.front());
+		bulkQueue.pop_front();
+		lane = ExecutorLane::BULK;
+		m_activeBulkTasks++;
 	}
 
 	return task;
@@ -43,51 +58,100 @@ std::unique_ptr<IExecutorTask> ExecutorTaskQueue::PopWait(std::condition_variabl
 
 void Executor::WorkerLoop()
 {
+	std::unique_lock<std::mutex> lock(m_workerMutex);
+
 	while (m_isRunning)
 	{
-		std::unique_ptr<IExecutorTask> task = m_workerQueue.PopWait(m_workerCV);
-		if (task)
+		ExecutorLane lane = ExecutorLane::INTERACTIVE;
+		std::unique_ptr<IExecutorTask> task = PopWorkerTask(lane);
+		if (!task)
 		{
-			task->Execute();
+			m_workerCV.wait(lock);
+			continue;
+		}
 
-			m_completedQueue.Push(std::move(task));
+		lock.unlock();
+
+		task->Execute();
+
+		m_completedQueue.Push(std::move(task));
+
+		lock.lock();
+
+		if (lane == ExecutorLane::BULK)
+		{
+			m_activeBulkTasks--;
+
+			// a waiting bulk task might be allowed to run now
+			m_workerCV.notify_one();
 		}
 	}
 }
 
 Executor::Executor()
 {
+	IConsole *pConsole = gEnv->pConsole;
+	pConsole->Register("executor_callbackBudget", &m_callbackBudget, 2.0f, VF_NOT_NET_SYNCED,
+		"Maximum time in milliseconds spent on completed async task callbacks per frame.\n"
+		"At least one callback is always processed.");
+
+	// the tasks are mostly blocking I/O, so keep the pool small but never below 2 workers
+	const unsigned int workerCount = std::clamp(WinAPI::GetLogicalProcessorCount(), 2U, 8U);
+
+	m_maxBulkTasks = workerCount - 1;
 	m_isRunning = true;
 
-	if (!m_workerThread.joinable())
+	for (unsigned int i = 0; i < workerCount; i++)
 	{
-		m_workerThread = std::thread(&Executor::WorkerLoop, this);
+		m_workerThreads.emplace_back(&Executor::WorkerLoop, this);
 	}
 }
 
 Executor::~Executor()
 {
-	m_isRunning = false;
+	{
+		std::lock_guard<std::mutex> lock(m_workerMutex);
+		m_isRunning = false;
+	}
+
+	m_workerCV.notify_all();
 
-	if (m_workerThread.joinable())
+	for (std::thread & thread : m_workerThreads)
 	{
-		m_workerCV.notify_all();
-		m_workerThread.join();
+		if (thread.joinable())
+		{
+			thread.join();
+		}
 	}
+
+	gEnv->pConsole->UnregisterVariable("executor_callbackBudget", true);
 }
 
 void Executor::OnUpdate()
 {
-	std::unique_ptr<IExecutorTask> task = m_completedQueue.Pop();
-	if (task)
+	const auto budget = std::chrono::duration<float, std::milli>(m_callbackBudget);
+	const auto start = std::chrono::steady_clock::now();
+
+	do
 	{
+		std::unique_ptr<IExecutorTask> task = m_completedQueue.Pop();
+		if (!task)
+		{
+			break;
+		}
+
 		task->Callback();
 	}
+	while ((std::chrono::steady_clock::now() - start) < budget);
 }
 
-void Executor::AddTask(std::unique_ptr<IExecutorTask> && task)
+void Executor::AddTask(std::unique_ptr<IExecutorTask> && task, ExecutorLane lane)
 {
-	m_workerQueue.Push(std::move(task));
+	{
+		std::lock_guard<std::mutex> lock(m_workerMutex);
+		m_workerQueues[static_cast<int>(lane)].emplace_back(std::move(task));
+	}
+
 	m_workerCV.notify_one();
 }
 
@@ -120,13 +184,13 @@ struct LambdaTask : public IExecutorTask
 	}
 };
 
-void Executor::RunAsync(Lambda onExecute, Lambda onCallback)
+void Executor::RunAsync(Lambda onExecute, Lambda onCallback, ExecutorLane lane)
 {
 	std::unique_ptr<LambdaTask> task = std::make_unique<LambdaTask>();
 	task->onExecute = std::move(onExecute);
 	task->onCallback = std::move(onCallback);
 
-	AddTask(std::move(task));
+	AddTask(std::move(task), lane);
 }
 
 void Executor::RunOnMainThread(Lambda onCallback)
@@ -6,6 +6,15 @@
 #include <mutex>
 #include <condition_variable>
 #include <functional>
+#include <vector>
+
+enum class ExecutorLane
+{
+	INTERACTIVE,  // short requests someone is waiting for, e.g. HTTP API calls
+	BULK,         // long-running transfers, e.g. map downloads
+
+	COUNT
+};
 
 struct IExecutorTask
 {
@@ -29,17 +38,22 @@ public:
 	void Push(std::unique_ptr<IExecutorTask> && task);
 
 	std::unique_ptr<IExecutorTask> Pop();
-	std::unique_ptr<IExecutorTask> PopWait(std::condition_variable & cv);
 };
 
 class Executor
 {
-	std::thread m_workerThread;
+	std::vector<std::thread> m_workerThreads;
+	std::mutex m_workerMutex;
 	std::condition_variable m_workerCV;
-	ExecutorTaskQueue m_workerQueue;
+	std::deque<std::unique_ptr<IExecutorTask>> m_workerQueues[static_cast<int>(ExecutorLane::COUNT)];
+	unsigned int m_activeBulkTasks = 0;
+	unsigned int m_maxBulkTasks = 0;
 	ExecutorTaskQueue m_completedQueue;
 	bool m_isRunning = false;
 
+	float m_callbackBudget = 0;  // milliseconds
+
+	std::unique_ptr<IExecutorTask> PopWorkerTask(ExecutorLane & lane);
 	void WorkerLoop();
 
 public:
@@ -50,13 +64,18 @@ public:
 	void OnUpdate();
 
 	// thread-safe
-	void AddTask(std::unique_ptr<IExecutorTask> && task);
+	void AddTask(std::unique_ptr<IExecutorTask> && task, ExecutorLane lane = ExecutorLane::INTERACTIVE);
 	void AddTaskCompleted(std::unique_ptr<IExecutorTask> && task);
 
 	// alternative to IExecutorTask
 	using Lambda = std::function<void()>;
 
 	// thread-safe
-	void RunAsync(Lambda onExecute, Lambda onCallback = Lambda());
+	void RunAsync(Lambda onExecute, Lambda onCallback = Lambda(), ExecutorLane lane = ExecutorLane::INTERACTIVE);
 	void RunOnMainThread(Lambda onCallback);
+
+	unsigned int GetWorkerCount() const
+	{
+		return static_cast<unsigned int>(m_workerThreads.size());
+	}
 };
@@ -16,6 +16,7 @@ const char *HTTP::StatusCodeToString(int code)
 		case HTTP::STATUS_CREATED:               return "Created";
 		case HTTP::STATUS_ACCEPTED:              return "Accepted";
 		case HTTP::STATUS_NO_CONTENT:            return "No Content";
+		case HTTP::STATUS_PARTIAL_CONTENT:       return "Partial Content";
 
 		case HTTP::STATUS_MOVED_PERMANENTLY:     return "Moved Permanently";
 		case HTTP::STATUS_FOUND:                 return "Found";
@@ -27,6 +28,7 @@ const char *HTTP::StatusCodeToString(int code)
 		case HTTP::STATUS_UNAUTHORIZED:          return "Unauthorized";
 		case HTTP::STATUS_FORBIDDEN:             return "Forbidden";
 		case HTTP::STATUS_NOT_FOUND:             return "Not Found";
+		case HTTP::STATUS_RANGE_NOT_SATISFIABLE: return "Range Not Satisfiable";
 
 		case HTTP::STATUS_INTERNAL_SERVER_ERROR: return "Internal Server Error";
 		case HTTP::STATUS_NOT_IMPLEMENTED:       return "Not Implemented";
@@ -11,6 +11,7 @@ namespace HTTP
 		STATUS_CREATED               = 201,
 		STATUS_ACCEPTED              = 202,
 		STATUS_NO_CONTENT            = 204,
+		STATUS_PARTIAL_CONTENT       = 206,
 
 		STATUS_MOVED_PERMANENTLY     = 301,
 		STATUS_FOUND                 = 302,
@@ -22,6 +23,7 @@ namespace HTTP
 		STATUS_UNAUTHORIZED          = 401,
 		STATUS_FORBIDDEN             = 403,
 		STATUS_NOT_FOUND             = 404,
+		STATUS_RANGE_NOT_SATISFIABLE = 416,
 
 		STATUS_INTERNAL_SERVER_ERROR = 500,
 		STATUS_NOT_IMPLEMENTED       = 501,
@@ -1,3 +1,6 @@
+#include <chrono>
+#include <mutex>
+
 #include "CryCommon/CrySystem/ISystem.h"
 #include "Library/Util.h"
 #include "Library/WinAPI.h"
@@ -5,10 +8,141 @@
 #include "HTTPClient.h"
 #include "Executor.h"
 
+class HTTPConnectionPool
+{
+	struct Connection
+	{
+		void *handle = nullptr;
+		unsigned int activeRequests = 0;
+		std::chrono::steady_clock::time_point lastUsed;
+	};
+
+	std::mutex m_mutex;
+	void *m_session = nullptr;
+	std::map<std::string, Connection> m_connections;  // key is "host:port"
+
+	// WinHTTP queues requests above this limit until a connection to the server becomes free
+	static constexpr unsigned int MAX_CONNECTIONS_PER_SERVER = 4;
+
+	static constexpr auto IDLE_TIMEOUT = std::chrono::seconds(60);
+
+	void EvictIdle(std::chrono::steady_clock::time_point now)
+	{
+		for (auto it = m_connections.begin(); it != m_connections.end();)
+		{
+			const Connection & connection = it->second;
+
+			if (connection.activeRequests == 0 && (now - connection.lastUsed) >= IDLE_TIMEOUT)
+			{
+				WinAPI::HTTPHandleClose(connection.handle);
+				it = m_connections.erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+	}
+
+public:
+	class Lease
+	{
+		HTTPConnectionPool *m_pool = nullptr;
+		std::string m_key;
+		void *m_handle = nullptr;
+
+		friend class HTTPConnectionPool;
+
+	public:
+		Lease() = default;
+
+		Lease(const Lease &) = delete;
+		Lease & operator=(const Lease &) = delete;
+
+		~Lease()
+		{
+			if (m_pool)
+			{
+				m_pool->Release(m_key);
+			}
+		}
+
+		void *GetHandle() const
+		{
+			return m_handle;
+		}
+	};
+
+	HTTPConnectionPool() = default;
+
+	~HTTPConnectionPool()
+	{
+		for (auto & [key, connection] : m_connections)
+		{
+			WinAPI::HTTPHandleClose(connection.handle);
+		}
+
+		WinAPI::HTTPHandleClose(m_session);
+	}
+
+	// worker thread
+	void Acquire(Lease & lease, const WinAPI::HTTPURLComponents & url)
+	{
+		const auto now = std::chrono::steady_clock::now();
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		EvictIdle(now);
+
+		if (!m_session)
+		{
+			m_session = WinAPI::HTTPSessionOpen(MAX_CONNECTIONS_PER_SERVER);
+		}
+
+		std::string key = url.host + ':' + std::to_string(url.port);
+
+		Connection & connection = m_connections[key];
+
+		if (!connection.handle)
+		{
+			try
+			{
+				connection.handle = WinAPI::HTTPConnectionOpen(m_session, url.host, url.port);
+			}
+			catch (...)
+			{
+				m_connections.erase(key);
+				throw;
+			}
+		}
+
+		connection.activeRequests++;
+		connection.lastUsed = now;
+
+		lease.m_pool = this;
+		lease.m_key = std::move(key);
+		lease.m_handle = connection.handle;
+	}
+
+	// worker thread
+	void Release(const std::string & key)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		auto it = m_connections.find(key);
+		if (it != m_connections.end())
+		{
+			it->second.activeRequests--;
+			it->second.lastUsed = std::chrono::steady_clock::now();
+		}
+	}
+};
+
 struct HTTPClientTask : public IExecutorTask
 {
 	HTTPClientRequest request;
 	HTTPClientResult result;
+	std::shared_ptr<HTTPConnectionPool> pool;
 
 	// worker thread
 	void Execute() override
@@ -17,13 +151,20 @@ struct HTTPClientTask : public IExecutorTask
 
 		try
 		{
+			const WinAPI::HTTPURLComponents url = WinAPI::HTTPCrackURL(request.url);
+
+			HTTPConnectionPool::Lease connection;
+			pool->Acquire(connection, url);
+
 			result.code = WinAPI::HTTPRequest(
+				connection.GetHandle(),
+				url.isSecure,
 				request.method,
-				request.url,
+				url.path,
 				request.data,
 				request.headers,
 				request.timeout,
-				[this](uint64_t contentLength, const WinAPI::HTTPRequestReader & reader)
+				[this](int statusCode, uint64_t contentLength, const WinAPI::HTTPRequestReader & reader)
 				{
 					// content length is zero if not provided by the server
 					result.response.reserve(contentLength);
@@ -57,7 +198,7 @@ struct HTTPClientTask : public IExecutorTask
 	}
 };
 
-HTTPClient::HTTPClient(Executor& executor) : m_executor(&executor)
+HTTPClient::HTTPClient(Executor& executor) : m_executor(&executor), m_pool(std::make_shared<HTTPConnectionPool>())
 {
 }
 
@@ -69,6 +210,7 @@ void HTTPClient::Request(HTTPClientRequest&& request)
 {
 	std::unique_ptr<HTTPClientTask> task = std::make_unique<HTTPClientTask>();
 	task->request = std::move(request);
+	task->pool = m_pool;
 
 	m_executor->AddTask(std::move(task));
 }
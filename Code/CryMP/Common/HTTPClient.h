@@ -1,6 +1,7 @@
 #pragma once
 
 #include <map>
+#include <memory>
 #include <string>
 #include <string_view>
 #include <functional>
@@ -8,6 +9,7 @@
 #include "HTTP.h"
 
 class Executor;
+class HTTPConnectionPool;
 
 struct HTTPClientResult
 {
@@ -30,6 +32,9 @@ class HTTPClient
 {
 	Executor* m_executor = nullptr;
 
+	// shared with running tasks, which can outlive the client
+	std::shared_ptr<HTTPConnectionPool> m_pool;
+
 public:
 	explicit HTTPClient(Executor& executor);
 	~HTTPClient();
@@ -0,0 +1,128 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "CryCommon/CrySystem/ISystem.h"
+
+#include "ScriptAllocator.h"
+
+void *ScriptAllocator::AllocateSmall(size_t sizeClass)
+{
+	FreeBlock *block = m_freeLists[sizeClass];
+
+	if (block)
+	{
+		m_freeLists[sizeClass] = block->next;
+
+		return block;
+	}
+
+	const size_t blockSize = (sizeClass + 1) * GRANULARITY;
+
+	if (static_cast<size_t>(m_pageEnd - m_pageCursor) < blockSize)
+	{
+		// the rest of the current page is wasted, it is smaller than the largest class
+		char *page = static_cast<char*>(AllocateLarge(PAGE_SIZE));
+
+		m_pages.push_back(page);
+		m_pageCursor = page;
+		m_pageEnd = page + PAGE_SIZE;
+	}
+
+	void *result = m_pageCursor;
+	m_pageCursor += blockSize;
+
+	return result;
+}
+
+void ScriptAllocator::DeallocateSmall(void *block, size_t sizeClass)
+{
+	FreeBlock *freeBlock = static_cast<FreeBlock*>(block);
+
+	freeBlock->next = m_freeLists[sizeClass];
+	m_freeLists[sizeClass] = freeBlock;
+}
+
+void *ScriptAllocator::AllocateLarge(size_t size)
+{
+	void *block = malloc(size);
+
+	// we never fail
+	if (!block)
+	{
+		// quit
+		gEnv->pSystem->Error("[ScriptSystem] Out of memory");
+	}
+
+	return block;
+}
+
+void ScriptAllocator::AddLiveSize(size_t oldSize, size_t newSize)
+{
+	m_liveSize = m_liveSize - oldSize + newSize;
+
+	if (m_liveSize > m_peakSize)
+	{
+		m_peakSize = m_liveSize;
+	}
+}
+
+ScriptAllocator::~ScriptAllocator()
+{
+	for (void *page : m_pages)
+	{
+		free(page);
+	}
+}
+
+void *ScriptAllocator::Reallocate(void *block, size_t oldSize, size_t newSize)
+{
+	AddLiveSize(oldSize, newSize);
+
+	const size_t oldClass = (oldSize > 0) ? GetClass(oldSize) : CLASS_COUNT;
+	const size_t newClass = (newSize > 0) ? GetClass(newSize) : CLASS_COUNT;
+
+	if (newSize == 0)
+	{
+		if (oldSize > 0)
+		{
+			if (oldClass < CLASS_COUNT)
+				DeallocateSmall(block, oldClass);
+			else
+				free(block);
+		}
+
+		return nullptr;
+	}
+
+	if (oldSize > 0 && oldClass == newClass)
+	{
+		if (newClass < CLASS_COUNT)
+		{
+			// the block is large enough already
+			return block;
+		}
+
+		void *newBlock = realloc(block, newSize);
+
+		if (!newBlock)
+		{
+			gEnv->pSystem->Error("[ScriptSystem] Out of memory");
+		}
+
+		return newBlock;
+	}
+
+	void *newBlock = (newClass < CLASS_COUNT) ? AllocateSmall(newClass) : AllocateLarge(newSize);
+
+	if (oldSize > 0)
+	{
+		memcpy(newBlock, block, (oldSize < newSize) ? oldSize : newSize);
+
+		if (oldClass < CLASS_COUNT)
+			DeallocateSmall(block, oldClass);
+		else
+			free(block);
+	}
+
+	return newBlock;
+}
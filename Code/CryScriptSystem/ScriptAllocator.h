@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stddef.h>
+#include <vector>
+
+// Lua allocator with size classes for small objects
+// not thread-safe, every Lua state has its own
+class ScriptAllocator
+{
+	static constexpr size_t GRANULARITY = 16;
+	static constexpr size_t MAX_SMALL_SIZE = 512;
+	static constexpr size_t CLASS_COUNT = MAX_SMALL_SIZE / GRANULARITY;
+	static constexpr size_t PAGE_SIZE = 64 * 1024;
+
+	struct FreeBlock
+	{
+		FreeBlock *next;
+	};
+
+	FreeBlock *m_freeLists[CLASS_COUNT] = {};
+	std::vector<void*> m_pages;
+	char *m_pageCursor = nullptr;
+	char *m_pageEnd = nullptr;
+
+	size_t m_liveSize = 0;
+	size_t m_peakSize = 0;
+
+	static size_t GetClass(size_t size)
+	{
+		// large blocks have no class
+		return (size > MAX_SMALL_SIZE) ? CLASS_COUNT : (size - 1) / GRANULARITY;
+	}
+
+	void *AllocateSmall(size_t sizeClass);
+	void DeallocateSmall(void *block, size_t sizeClass);
+
+	void *AllocateLarge(size_t size);
+
+	void AddLiveSize(size_t oldSize, size_t newSize);
+
+public:
+	ScriptAllocator() = default;
+	~ScriptAllocator();
+
+	ScriptAllocator(const ScriptAllocator&) = delete;
+	ScriptAllocator& operator=(const ScriptAllocator&) = delete;
+
+	// lua_Alloc semantics, never fails
+	void *Reallocate(void *block, size_t oldSize, size_t newSize);
+
+	size_t GetLiveSize() const
+	{
+		return m_liveSize;
+	}
+
+	size_t GetPeakSize() const
+	{
+		return m_peakSize;
+	}
+
+	size_t GetPooledSize() const
+	{
+		return m_pages.size() * PAGE_SIZE;
+	}
+};
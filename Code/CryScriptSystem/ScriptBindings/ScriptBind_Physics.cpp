@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "CryCommon/CrySystem/ISystem.h"
 #include "CryCommon/CryPhysics/IPhysics.h"
 #include "CryCommon/Cry3DEngine/I3DEngine.h"
@@ -6,6 +8,10 @@
 
 #include "ScriptBind_Physics.h"
 
+#define PHYS_FOREIGN_ID_SCRIPT_RAY_BATCH PHYS_FOREIGN_ID_USER+4
+
+static constexpr int MAX_BATCH_RAY_COUNT = 1024;
+
 ScriptBind_Physics::ScriptBind_Physics(IScriptSystem *pSS)
 {
 	CScriptableBase::Init(pSS, gEnv->pSystem);
@@ -19,7 +25,150 @@ ScriptBind_Physics::ScriptBind_Physics(IScriptSystem *pSS)
 	SCRIPT_REG_TEMPLFUNC(RegisterExplosionCrack, "sGeometryFile, nIdMaterial");
 	SCRIPT_REG_FUNC(RayWorldIntersection);
 	SCRIPT_REG_TEMPLFUNC(RayTraceCheck, "vSrc, vTrg, hSkipEntityId1, hSkipEntityId2");
+	SCRIPT_REG_TEMPLFUNC(RayCastBatch, "tOrigins, tDirections, [nEntTypes], [tSkipEntityIds], [fCallback]");
 	SCRIPT_REG_TEMPLFUNC(SamplePhysEnvironment, "vPoint, fRadius");
+
+	gEnv->pSystem->GetISystemEventDispatcher()->RegisterListener(this);
+}
+
+ScriptBind_Physics::~ScriptBind_Physics()
+{
+	gEnv->pSystem->GetISystemEventDispatcher()->RemoveListener(this);
+
+	if (m_isRayResultClient && gEnv->pPhysicalWorld)
+	{
+		gEnv->pPhysicalWorld->RemoveEventClient(EventPhysRWIResult::id, OnRayResult, 0);
+	}
+
+	// the Lua state is closed already
+	// rays still queued in the physical world would write to freed memory, so unfinished batches are leaked
+	for (auto & pBatch : m_rayBatches)
+	{
+		if (pBatch->pendingRayCount.load(std::memory_order_acquire) != 0)
+			pBatch.release();
+	}
+}
+
+void ScriptBind_Physics::Update()
+{
+	if (m_rayBatches.empty())
+		return;
+
+	FUNCTION_PROFILER(gEnv->pSystem, PROFILE_SCRIPT);
+
+	std::vector<std::unique_ptr<RayBatch>> finishedBatches;
+
+	for (auto it = m_rayBatches.begin(); it != m_rayBatches.end();)
+	{
+		if ((*it)->pendingRayCount.load(std::memory_order_acquire) == 0)
+		{
+			finishedBatches.emplace_back(std::move(*it));
+			it = m_rayBatches.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+
+	// the callbacks can queue new batches
+	for (const auto & pBatch : finishedBatches)
+	{
+		SmartScriptTable results = CreateRayBatchResults(*pBatch);
+
+		Script::Call(m_pSS, pBatch->callback, results.GetPtr());
+
+		m_pSS->ReleaseFunc(pBatch->callback);
+	}
+}
+
+void ScriptBind_Physics::OnSystemEvent(ESystemEvent event, UINT_PTR wParam, UINT_PTR lParam)
+{
+	if (event == ESYSTEM_EVENT_LEVEL_LOAD_START || event == ESYSTEM_EVENT_LEVEL_RELOAD)
+	{
+		CancelRayBatches();
+	}
+}
+
+void ScriptBind_Physics::CancelRayBatches()
+{
+	if (m_rayBatches.empty())
+		return;
+
+	// finish what is still queued, rays dropped by the physical world never report back
+	gEnv->pPhysicalWorld->TracePendingRays();
+
+	int droppedRayCount = 0;
+
+	for (const auto & pBatch : m_rayBatches)
+	{
+		droppedRayCount += pBatch->pendingRayCount.load(std::memory_order_acquire);
+
+		// the results belong to the previous level, so the callbacks are not called
+		m_pSS->ReleaseFunc(pBatch->callback);
+	}
+
+	if (droppedRayCount > 0)
+		CryLog("Physics.RayCastBatch: Cancelled %d batches with %d dropped rays", static_cast<int>(m_rayBatches.size()), droppedRayCount);
+
+	m_rayBatches.clear();
+}
+
+int ScriptBind_Physics::OnRayResult(const EventPhys *pEvent)
+{
+	const EventPhysRWIResult *pResult = static_cast<const EventPhysRWIResult*>(pEvent);
+
+	if (pResult->iForeignData != PHYS_FOREIGN_ID_SCRIPT_RAY_BATCH)
+		return 1;
+
+	Ray *pRay = static_cast<Ray*>(pResult->pForeignData);
+
+	if (pResult->nHits > 0)
+	{
+		if (pResult->pHits != &pRay->hit)
+			pRay->hit = pResult->pHits[0];
+
+		pRay->hitCount = 1;
+		pRay->hitEntityId = GetHitEntityId(pRay->hit);
+	}
+
+	pRay->pBatch->pendingRayCount.fetch_sub(1, std::memory_order_release);
+
+	return 1;
+}
+
+EntityId ScriptBind_Physics::GetHitEntityId(const ray_hit & hit)
+{
+	IEntity *pEntity = hit.pCollider ? static_cast<IEntity*>(hit.pCollider->GetForeignData(PHYS_FOREIGN_ID_ENTITY)) : nullptr;
+
+	return pEntity ? pEntity->GetId() : 0;
+}
+
+SmartScriptTable ScriptBind_Physics::CreateRayBatchResults(const RayBatch & batch)
+{
+	SmartScriptTable results(m_pSS);
+
+	// packed as distance, entity ID and surface index per ray, the distance is -1 if nothing was hit
+	for (int i = 0; i < static_cast<int>(batch.rays.size()); i++)
+	{
+		const Ray & ray = batch.rays[i];
+		const int base = i * 3;
+
+		if (ray.hitCount > 0)
+		{
+			results->SetAt(base + 1, ray.hit.dist);
+			results->SetAt(base + 2, ScriptHandle(ray.hitEntityId));
+			results->SetAt(base + 3, ray.hit.surface_idx);
+		}
+		else
+		{
+			results->SetAt(base + 1, -1.0f);
+			results->SetAt(base + 2, ScriptHandle(0));
+			results->SetAt(base + 3, 0);
+		}
+	}
+
+	return results;
 }
 
 int ScriptBind_Physics::SimulateExplosion(IFunctionHandler *pH, SmartScriptTable explisionTable)
@@ -235,6 +384,96 @@ int ScriptBind_Physics::RayTraceCheck(IFunctionHandler *pH, Vec3 src, Vec3 dst,
 	return pH->EndFunction(static_cast<bool>(nHits == 0));
 }
 
+int ScriptBind_Physics::RayCastBatch(IFunctionHandler *pH, SmartScriptTable origins, SmartScriptTable directions)
+{
+	int entTypes = ent_all;
+	SmartScriptTable skipEntityIds;
+	HSCRIPTFUNCTION callback = nullptr;
+
+	const int nParams = pH->GetParamCount();
+
+	if (nParams >= 3 && pH->GetParamType(3) != svtNull)
+		pH->GetParam(3, entTypes);
+
+	if (nParams >= 4 && pH->GetParamType(4) != svtNull)
+		pH->GetParam(4, skipEntityIds);
+
+	if (nParams >= 5 && pH->GetParamType(5) == svtFunction)
+		pH->GetParam(5, callback);
+
+	int rayCount = std::min(origins->Count(), directions->Count());
+
+	if (rayCount > MAX_BATCH_RAY_COUNT)
+	{
+		CryLogWarning("Physics.RayCastBatch: Only %d of %d rays are cast", MAX_BATCH_RAY_COUNT, rayCount);
+		rayCount = MAX_BATCH_RAY_COUNT;
+	}
+
+	if (callback && !m_isRayResultClient)
+	{
+		gEnv->pPhysicalWorld->AddEventClient(EventPhysRWIResult::id, OnRayResult, 0);
+		m_isRayResultClient = true;
+	}
+
+	auto pBatch = std::make_unique<RayBatch>();
+	pBatch->rays.resize(rayCount);
+	pBatch->pendingRayCount = rayCount;
+	pBatch->callback = callback;
+
+	const int flags = geom_colltype0 << rwi_colltype_bit | rwi_stop_at_pierceable;
+
+	for (int i = 0; i < rayCount; i++)
+	{
+		Ray & ray = pBatch->rays[i];
+		ray.pBatch = pBatch.get();
+
+		Vec3 origin(0, 0, 0);
+		Vec3 direction(0, 0, 0);
+		origins->GetAt(i + 1, origin);
+		directions->GetAt(i + 1, direction);
+
+		// two entities to skip per ray, e.g. the observer and the target
+		int skipEntCount = 0;
+
+		for (int j = 0; j < 2 && skipEntityIds; j++)
+		{
+			ScriptHandle skipId;
+			if (skipEntityIds->GetAt((i * 2) + j + 1, skipId))
+			{
+				IEntity *pSkipEntity = gEnv->pEntitySystem->GetEntity(static_cast<EntityId>(skipId.n));
+				if (pSkipEntity && pSkipEntity->GetPhysics())
+					ray.skipEnts[skipEntCount++] = pSkipEntity->GetPhysics();
+			}
+		}
+
+		if (callback)
+		{
+			// traced by the physics thread, the callback gets the results in one of the next frames
+			gEnv->pPhysicalWorld->RayWorldIntersection(origin, direction, entTypes, flags | rwi_queue, &ray.hit, 1,
+				ray.skipEnts, skipEntCount, &ray, PHYS_FOREIGN_ID_SCRIPT_RAY_BATCH);
+		}
+		else
+		{
+			ray.hitCount = gEnv->pPhysicalWorld->RayWorldIntersection(origin, direction, entTypes, flags, &ray.hit, 1,
+				ray.skipEnts, skipEntCount);
+
+			if (ray.hitCount > 0)
+				ray.hitEntityId = GetHitEntityId(ray.hit);
+		}
+	}
+
+	if (!callback)
+	{
+		SmartScriptTable results = CreateRayBatchResults(*pBatch);
+
+		return pH->EndFunction(*results);
+	}
+
+	m_rayBatches.emplace_back(std::move(pBatch));
+
+	return pH->EndFunction(true);
+}
+
 int ScriptBind_Physics::SamplePhysEnvironment(IFunctionHandler *pH)
 {
 	int i = 0;
@@ -1,16 +1,59 @@
 #pragma once
 
+#include <atomic>
+#include <memory>
+#include <vector>
+
 #include "CryCommon/CryScriptSystem/IScriptSystem.h"
+#include "CryCommon/CryPhysics/IPhysics.h"
+#include "CryCommon/CrySystem/ISystem.h"
 
-class ScriptBind_Physics : public CScriptableBase
+class ScriptBind_Physics : public CScriptableBase, public ISystemEventListener
 {
+	struct RayBatch;
+
+	struct Ray
+	{
+		RayBatch *pBatch = nullptr;
+		IPhysicalEntity *skipEnts[2] = {};
+		ray_hit hit = {};  // only valid in OnRayResult, the collider can be gone by the time the batch is delivered
+		int hitCount = 0;
+		EntityId hitEntityId = 0;
+	};
+
+	// rays queued in the physical world, the results are written by the physics thread
+	struct RayBatch
+	{
+		std::vector<Ray> rays;
+		std::atomic<int> pendingRayCount = 0;
+		HSCRIPTFUNCTION callback = nullptr;
+	};
+
+	std::vector<std::unique_ptr<RayBatch>> m_rayBatches;
+	bool m_isRayResultClient = false;
+
+	static int OnRayResult(const EventPhys *pEvent);
+	static EntityId GetHitEntityId(const ray_hit & hit);
+
+	void CancelRayBatches();
+
+	SmartScriptTable CreateRayBatchResults(const RayBatch & batch);
+
 public:
 	ScriptBind_Physics(IScriptSystem *pSS);
+	~ScriptBind_Physics();
+
+	// delivers finished ray batches, once per frame
+	void Update();
+
+	// ISystemEventListener
+	void OnSystemEvent(ESystemEvent event, UINT_PTR wParam, UINT_PTR lParam) override;
 
 	int SimulateExplosion(IFunctionHandler *pH, SmartScriptTable explosionParams);
 	int RegisterExplosionShape(IFunctionHandler *pH, const char *sGeometryFile, float fSize, int nIdMaterial, float fProbability, const char *sSplintersFile, float fSplintersOffset, const char *sSplintersCloudEffect);
 	int RegisterExplosionCrack(IFunctionHandler *pH, const char *sGeometryFile, int nIdMaterial);
 	int RayWorldIntersection(IFunctionHandler *pH);
 	int RayTraceCheck(IFunctionHandler *pH, Vec3 src, Vec3 dst, ScriptHandle skipEntityId1, ScriptHandle skipEntityId2);
+	int RayCastBatch(IFunctionHandler *pH, SmartScriptTable origins, SmartScriptTable directions);
 	int SamplePhysEnvironment(IFunctionHandler *pH);
 };
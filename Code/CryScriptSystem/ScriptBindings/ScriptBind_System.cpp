@@ -1,3 +1,4 @@
+#include <math.h>
 #include <time.h>
 #include <string.h>
 #include <string>
@@ -16,6 +17,8 @@
 #include "CryCommon/CryMath/Cry_Camera.h"
 #include "CryCommon/CryMath/Cry_Geo.h"
 #include "CryCommon/CryRenderer/IRenderAuxGeom.h"
+#include "CryMP/Client/Client.h"
+#include "CryMP/Client/EntityIndex.h"
 
 #include "ScriptBind_System.h"
 
@@ -372,99 +375,88 @@ int ScriptBind_System::GetEntityClass(IFunctionHandler *pH)
 	return pH->EndFunction();
 }
 
-int ScriptBind_System::GetEntities(IFunctionHandler *pH)
+static EntityIndex *GetEntityIndex()
 {
-	Vec3 center(0, 0, 0);
-	float radius = 0;
-
-	if (pH->GetParamCount() > 1)
-	{
-		pH->GetParam(1, center);
-		pH->GetParam(2, radius);
-	}
+	// the client and its index do not exist yet while the first scripts are executed
+	return gClient ? gClient->GetEntityIndex() : nullptr;
+}
 
+int ScriptBind_System::EndEntityQuery(IFunctionHandler *pH, int firstIndex)
+{
 	SmartScriptTable pObj(m_pSS);
-	int k = 0;
+	int k = firstIndex;
 
-	IEntityItPtr pIIt = gEnv->pEntitySystem->GetEntityIterator();
-	IEntity *pEntity = nullptr;
-
-	while (pEntity = pIIt->Next())
+	for (IEntity *pEntity : m_queryResult)
 	{
-		if (radius)
-		{
-			if ((pEntity->GetWorldPos() - center).len2() > radius*radius)
-			{
-				continue;
-			}
-		}
-
 		if (pEntity->GetScriptTable())
 		{
-			pObj->SetAt(k, pEntity->GetScriptTable());
-			k++;
+			pObj->SetAt(k++, pEntity->GetScriptTable());
 		}
 	}
 
+	m_queryResult.clear();
+
 	return pH->EndFunction(*pObj);
 }
 
-int ScriptBind_System::GetEntitiesByClass(IFunctionHandler *pH, const char *entityClass)
+void ScriptBind_System::QueryEntities(IEntityClass *pClass, const Vec3 & center, float radius)
 {
-	if (!entityClass || !*entityClass)
-		return pH->EndFunction();
+	m_queryResult.clear();
 
-	IEntityClass *pClass = gEnv->pEntitySystem->GetClassRegistry()->FindClass(entityClass);
-	if (!pClass)
+	// negative radius means no sphere
+	EntityIndex *pIndex = GetEntityIndex();
+
+	if (pIndex && radius >= 0)
 	{
-		return pH->EndFunction();
+		pIndex->GetEntitiesInSphere(center, radius, pClass, m_queryResult);
+		return;
+	}
+
+	if (pIndex && pClass)
+	{
+		pIndex->GetEntitiesByClass(pClass, m_queryResult);
+		return;
 	}
 
-	SmartScriptTable pObj(m_pSS);
 	IEntityItPtr pIIt = gEnv->pEntitySystem->GetEntityIterator();
 	IEntity *pEntity = nullptr;
-	int k = 1;
 
 	pIIt->MoveFirst();
 
 	while (pEntity = pIIt->Next())
 	{
-		if (pEntity->GetClass() == pClass)
+		if (pClass && pEntity->GetClass() != pClass)
 		{
-			if (pEntity->GetScriptTable())
-			{
-				pObj->SetAt(k++, pEntity->GetScriptTable());
-			}
+			continue;
 		}
-	}
 
-	return pH->EndFunction(*pObj);
+		if (radius >= 0 && (pEntity->GetWorldPos() - center).len2() > radius*radius)
+		{
+			continue;
+		}
+
+		m_queryResult.push_back(pEntity);
+	}
 }
 
-int ScriptBind_System::GetEntitiesInSphere(IFunctionHandler *pH, Vec3 center, float radius)
+int ScriptBind_System::GetEntities(IFunctionHandler *pH)
 {
-	SmartScriptTable pObj(m_pSS);
-	IEntityItPtr pIIt = gEnv->pEntitySystem->GetEntityIterator();
-	IEntity *pEntity = nullptr;
-	int k = 1;
-
-	pIIt->MoveFirst();
+	Vec3 center(0, 0, 0);
+	float radius = 0;
 
-	while (pEntity = pIIt->Next())
+	if (pH->GetParamCount() > 1)
 	{
-		if ((pEntity->GetWorldPos() - center).len2() <= radius  *radius)
-		{
-			if (pEntity->GetScriptTable())
-			{
-				pObj->SetAt(k++, pEntity->GetScriptTable());
-			}
-		}
+		pH->GetParam(1, center);
+		pH->GetParam(2, radius);
 	}
 
-	return pH->EndFunction(*pObj);
+	// zero radius means all entities
+	QueryEntities(nullptr, center, radius ? fabsf(radius) : -1);
+
+	return EndEntityQuery(pH, 0);
 }
 
-int ScriptBind_System::GetEntitiesInSphereByClass(IFunctionHandler *pH, Vec3 center, float radius, const char *entityClass)
+int ScriptBind_System::GetEntitiesByClass(IFunctionHandler *pH, const char *entityClass)
 {
 	if (!entityClass || !*entityClass)
 		return pH->EndFunction();
@@ -475,25 +467,32 @@ int ScriptBind_System::GetEntitiesInSphereByClass(IFunctionHandler *pH, Vec3 cen
 		return pH->EndFunction();
 	}
 
-	SmartScriptTable pObj(m_pSS);
-	IEntityItPtr pIIt = gEnv->pEntitySystem->GetEntityIterator();
-	IEntity *pEntity = 0;
-	int k = 1;
+	QueryEntities(pClass, Vec3(0, 0, 0), -1);
 
-	pIIt->MoveFirst();
+	return EndEntityQuery(pH, 1);
+}
 
-	while (pEntity = pIIt->Next())
+int ScriptBind_System::GetEntitiesInSphere(IFunctionHandler *pH, Vec3 center, float radius)
+{
+	QueryEntities(nullptr, center, fabsf(radius));
+
+	return EndEntityQuery(pH, 1);
+}
+
+int ScriptBind_System::GetEntitiesInSphereByClass(IFunctionHandler *pH, Vec3 center, float radius, const char *entityClass)
+{
+	if (!entityClass || !*entityClass)
+		return pH->EndFunction();
+
+	IEntityClass *pClass = gEnv->pEntitySystem->GetClassRegistry()->FindClass(entityClass);
+	if (!pClass)
 	{
-		if ((pEntity->GetClass() == pClass) && ((pEntity->GetWorldPos() - center).len2() <= radius  *radius))
-		{
-			if (pEntity->GetScriptTable())
-			{
-				pObj->SetAt(k++, pEntity->GetScriptTable());
-			}
-		}
+		return pH->EndFunction();
 	}
 
-	return pH->EndFunction(*pObj);
+	QueryEntities(pClass, center, fabsf(radius));
+
+	return EndEntityQuery(pH, 1);
 }
 
 static bool Filter(struct __finddata64_t& fd, int nScanMode)
@@ -1,10 +1,19 @@
 #pragma once
 
+#include <vector>
+
 #include "CryCommon/CryScriptSystem/IScriptSystem.h"
 
+struct IEntity;
+struct IEntityClass;
+
 class ScriptBind_System : public CScriptableBase
 {
 	SmartScriptTable m_pScriptTimeTable;
+	std::vector<IEntity*> m_queryResult;
+
+	void QueryEntities(IEntityClass *pClass, const Vec3 & center, float radius);
+	int EndEntityQuery(IFunctionHandler *pH, int firstIndex);
 
 public:
 	ScriptBind_System(IScriptSystem *pSS);
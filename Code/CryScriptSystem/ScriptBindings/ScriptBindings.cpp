@@ -6,6 +6,14 @@
 #include "ScriptBind_Script.h"
 #include "ScriptBind_Physics.h"
 
+ScriptBindings::ScriptBindings()
+{
+}
+
+ScriptBindings::~ScriptBindings()
+{
+}
+
 void ScriptBindings::Init(IScriptSystem *pSS)
 {
 	m_pBindSystem   = std::make_unique<ScriptBind_System>(pSS);
@@ -15,3 +23,9 @@ void ScriptBindings::Init(IScriptSystem *pSS)
 	m_pBindScript   = std::make_unique<ScriptBind_Script>(pSS);
 	m_pBindPhysics  = std::make_unique<ScriptBind_Physics>(pSS);
 }
+
+void ScriptBindings::Update()
+{
+	if (m_pBindPhysics)
+		m_pBindPhysics->Update();
+}
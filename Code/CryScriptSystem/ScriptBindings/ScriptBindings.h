@@ -5,6 +5,7 @@
 struct IScriptSystem;
 
 class CScriptableBase;
+class ScriptBind_Physics;
 
 class ScriptBindings
 {
@@ -13,8 +14,12 @@ class ScriptBindings
 	std::unique_ptr<CScriptableBase> m_pBindSound;
 	std::unique_ptr<CScriptableBase> m_pBindMovie;
 	std::unique_ptr<CScriptableBase> m_pBindScript;
-	std::unique_ptr<CScriptableBase> m_pBindPhysics;
+	std::unique_ptr<ScriptBind_Physics> m_pBindPhysics;
 
 public:
+	ScriptBindings();
+	~ScriptBindings();
+
 	void Init(IScriptSystem *pSS);
+	void Update();
 };
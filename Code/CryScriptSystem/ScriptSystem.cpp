@@ -14,6 +14,7 @@ extern "C"
 #include "CryCommon/CrySystem/IConsole.h"
 #include "CryCommon/CrySystem/ITimer.h"
 #include "CryCommon/CryAISystem/IAISystem.h"
+#include "Library/Util.h"
 
 #include "ScriptSystem.h"
 #include "ScriptTable.h"
@@ -24,6 +25,59 @@ extern "C"
 	int bitlib_init(lua_State *L);
 }
 
+static std::string SanitizeScriptFileName(const char *fileName)
+{
+	std::string result;
+
+	if (fileName)
+	{
+		result = fileName;
+
+		for (char& ch : result)
+		{
+			if (ch == '\\')
+			{
+				// convert backslashes to normal slashes
+				ch = '/';
+			}
+
+			// convert to lowercase
+			ch |= (ch >= 'A' && ch <= 'Z') << 5;
+		}
+	}
+
+	return result;
+}
+
+static uint64_t HashFileName(const char *data, size_t size)
+{
+	// FNV-1a, collisions only make scripts share a cache file, which is checked by the content hash
+	uint64_t hash = 0xCBF29CE484222325;
+
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= static_cast<unsigned char>(data[i]);
+		hash *= 0x100000001B3;
+	}
+
+	return hash;
+}
+
+static std::string GetBytecodeFilePath(const std::string & sanitizedName)
+{
+	char path[64];
+	sprintf_s(path, "%%USER%%/ScriptCache/%016llx.luac", HashFileName(sanitizedName.data(), sanitizedName.length()));
+
+	return path;
+}
+
+static int BytecodeWriter(lua_State *L, const void *data, size_t size, void *userData)
+{
+	static_cast<std::string*>(userData)->append(static_cast<const char*>(data), size);
+
+	return 0;
+}
+
 ScriptSystem::ScriptSystem()
 {
 	m_scripts.reserve(128);
@@ -38,6 +92,10 @@ void ScriptSystem::Init()
 {
 	LuaInit();
 
+	m_vectorKeys.x = InternKey("x");
+	m_vectorKeys.y = InternKey("y");
+	m_vectorKeys.z = InternKey("z");
+
 	m_timers.Init(this);
 	m_bindings.Init(this);
 
@@ -50,32 +108,22 @@ void ScriptSystem::Init()
 	pConsole->AddCommand("lua_dump_state", OnDumpStateCmd, 0, "Dumps the current state into a file.");
 	pConsole->AddCommand("lua_dump_scripts", OnDumpScriptsCmd, 0, "Dumps loaded scripts to the log.");
 	pConsole->AddCommand("lua_garbage_collect", OnGarbageCollectCmd, 0, "Forces garbage collection.");
+	pConsole->AddCommand("lua_memory_stats", OnMemoryStatsCmd, 0, "Shows Lua memory usage.");
+
+	pConsole->Register("lua_bytecode_cache", &m_bytecodeCacheLevel, 1, VF_NOT_NET_SYNCED,
+	  "Compiled script cache. 0 - off, 1 - memory, 2 - memory and disk");
 
 	ExecuteFile("Scripts/common.lua");
 }
 
 void *ScriptSystem::Allocate(size_t size)
 {
-	FUNCTION_PROFILER(gEnv->pSystem, PROFILE_SCRIPT);
-
-	// TODO: optimized memory allocator
-	void *block = malloc(size);
-
-	// we never fail
-	if (!block)
-	{
-		// quit
-		gEnv->pSystem->Error("[ScriptSystem] Out of memory");
-	}
-
-	return block;
+	return m_allocator.Reallocate(nullptr, 0, size);
 }
 
-void ScriptSystem::Deallocate(void *block)
+void ScriptSystem::Deallocate(void *block, size_t size)
 {
-	FUNCTION_PROFILER(gEnv->pSystem, PROFILE_SCRIPT);
-
-	free(block);
+	m_allocator.Reallocate(block, size, 0);
 }
 
 void ScriptSystem::PushAny(const ScriptAnyValue & any)
@@ -142,21 +190,36 @@ void ScriptSystem::PushAny(const ScriptAnyValue & any)
 
 void ScriptSystem::PushVec3(const Vec3 & vec)
 {
-	lua_newtable(m_L);
+	lua_createtable(m_L, 0, 3);
 
-	lua_pushlstring(m_L, "x", 1);
+	PushKey(m_vectorKeys.x);
 	lua_pushnumber(m_L, vec.x);
 	lua_settable(m_L, -3);
 
-	lua_pushlstring(m_L, "y", 1);
+	PushKey(m_vectorKeys.y);
 	lua_pushnumber(m_L, vec.y);
 	lua_settable(m_L, -3);
 
-	lua_pushlstring(m_L, "z", 1);
+	PushKey(m_vectorKeys.z);
 	lua_pushnumber(m_L, vec.z);
 	lua_settable(m_L, -3);
 }
 
+ScriptKey ScriptSystem::InternKey(const char *key)
+{
+	lua_pushstring(m_L, key);
+
+	ScriptKey result;
+	result.ref = lua_ref(m_L, 1);
+
+	return result;
+}
+
+void ScriptSystem::PushKey(ScriptKey key)
+{
+	lua_getref(m_L, key.ref);
+}
+
 bool ScriptSystem::PopAny(ScriptAnyValue & any)
 {
 	const bool status = ToAny(any, -1);
@@ -433,6 +496,7 @@ void ScriptSystem::Update()
 	LuaGarbageCollectStep();
 
 	m_timers.Update();
+	m_bindings.Update();
 }
 
 void ScriptSystem::SetGCFrequency(const float rate)
@@ -467,8 +531,8 @@ bool ScriptSystem::ExecuteFile(const char *fileName, bool raiseError, bool force
 			// TODO: maybe use real path from CryPak instead?
 			const char *description = fileName;
 
-			// execute the file
-			success = ExecuteBuffer(content.data(), content.size(), description);
+			// compile the file or take it from the cache and execute it
+			success = CompileFile(fileName, content.data(), content.size(), description) && LuaCall(0, LUA_MULTRET);
 		}
 		else
 		{
@@ -500,12 +564,8 @@ bool ScriptSystem::ExecuteBuffer(const char *buffer, size_t bufferSize, const ch
 	FUNCTION_PROFILER(gEnv->pSystem, PROFILE_SCRIPT);
 
 	// compile
-	if (luaL_loadbuffer(m_L, buffer, bufferSize, bufferDescription) != 0)
+	if (!CompileBuffer(buffer, bufferSize, bufferDescription))
 	{
-		const char *message = lua_tostring(m_L, -1);
-
-		CryLogErrorAlways("[Script] Parse error (%s): %s", bufferDescription, message);
-
 		return false;
 	}
 
@@ -915,7 +975,12 @@ int ScriptSystem::GetStackSize()
 
 uint32_t ScriptSystem::GetScriptAllocSize()
 {
-	return 0;
+	return static_cast<uint32_t>(m_allocator.GetLiveSize());
+}
+
+IScriptRecordSchema *ScriptSystem::CreateRecordSchema(const ScriptRecordField *fields, int fieldCount)
+{
+	return new ScriptRecordSchema(this, fields, fieldCount);
 }
 
 ///////////////////////
@@ -982,28 +1047,117 @@ bool ScriptSystem::LuaCall(int paramCount, int resultCount)
 	return (status == 0);
 }
 
-static std::string SanitizeScriptFileName(const char *fileName)
+bool ScriptSystem::CompileBuffer(const char *buffer, size_t bufferSize, const char *bufferDescription)
 {
-	std::string result;
+	if (luaL_loadbuffer(m_L, buffer, bufferSize, bufferDescription) != 0)
+	{
+		const char *message = lua_tostring(m_L, -1);
 
-	if (fileName)
+		CryLogErrorAlways("[Script] Parse error (%s): %s", bufferDescription, message);
+
+		lua_pop(m_L, 1);
+
+		return false;
+	}
+
+	return true;
+}
+
+bool ScriptSystem::CompileFile(const char *fileName, const char *content, size_t contentSize, const char *description)
+{
+	FUNCTION_PROFILER(gEnv->pSystem, PROFILE_SCRIPT);
+
+	if (m_bytecodeCacheLevel <= 0)
 	{
-		result = fileName;
+		return CompileBuffer(content, contentSize, description);
+	}
 
-		for (char& ch : result)
+	// scripts are reloaded on every connect, so skip the parser if the content did not change
+	const std::string sanitizedName = SanitizeScriptFileName(fileName);
+	// a server could craft a script colliding with a weak hash of another one and get its bytecode run
+	const std::string contentHash = Util::sha256(std::string_view(content, contentSize));
+
+	CompiledScript & compiled = m_bytecodeCache[sanitizedName];
+
+	if (compiled.contentHash != contentHash)
+	{
+		compiled.contentHash = contentHash;
+		compiled.bytecode.clear();
+
+		if (m_bytecodeCacheLevel >= 2)
 		{
-			if (ch == '\\')
-			{
-				// convert backslashes to normal slashes
-				ch = '/';
-			}
+			ReadBytecodeFile(sanitizedName, compiled);
+		}
+	}
 
-			// convert to lowercase
-			ch |= (ch >= 'A' && ch <= 'Z') << 5;
+	if (!compiled.bytecode.empty())
+	{
+		if (luaL_loadbuffer(m_L, compiled.bytecode.data(), compiled.bytecode.size(), description) == 0)
+		{
+			return true;
 		}
+
+		// damaged or incompatible bytecode
+		lua_pop(m_L, 1);
+
+		compiled.bytecode.clear();
 	}
 
-	return result;
+	if (!CompileBuffer(content, contentSize, description))
+	{
+		m_bytecodeCache.erase(sanitizedName);
+
+		return false;
+	}
+
+	lua_dump(m_L, BytecodeWriter, &compiled.bytecode);
+
+	if (m_bytecodeCacheLevel >= 2)
+	{
+		WriteBytecodeFile(sanitizedName, compiled);
+	}
+
+	return true;
+}
+
+void ScriptSystem::ReadBytecodeFile(const std::string & sanitizedName, CompiledScript & compiled)
+{
+	CCryFile file;
+
+	if (!file.Open(GetBytecodeFilePath(sanitizedName).c_str(), "rb"))
+	{
+		return;
+	}
+
+	const size_t fileSize = file.GetLength();
+	std::string contentHash(compiled.contentHash.length(), '\0');
+
+	// the file starts with the hash of the source it was compiled from
+	if (fileSize <= contentHash.length()
+	 || file.ReadRaw(contentHash.data(), contentHash.length()) != contentHash.length()
+	 || contentHash != compiled.contentHash)
+	{
+		return;
+	}
+
+	compiled.bytecode.resize(fileSize - contentHash.length());
+	compiled.bytecode.resize(file.ReadRaw(compiled.bytecode.data(), compiled.bytecode.size()));
+}
+
+void ScriptSystem::WriteBytecodeFile(const std::string & sanitizedName, const CompiledScript & compiled)
+{
+	gEnv->pCryPak->MakeDir("%USER%/ScriptCache");
+
+	CCryFile file;
+
+	if (!file.Open(GetBytecodeFilePath(sanitizedName).c_str(), "wb"))
+	{
+		CryLogWarning("[Script] Failed to write compiled %s", sanitizedName.c_str());
+		return;
+	}
+
+	file.Write(compiled.contentHash.data(), compiled.contentHash.length());
+	file.Write(compiled.bytecode.data(), compiled.bytecode.size());
 }
 
 bool ScriptSystem::AddToScripts(const char *fileName)
@@ -1072,33 +1226,11 @@ int ScriptSystem::PanicHandler(lua_State *L)
 
 void *ScriptSystem::LuaAllocator(void *userData, void *originalBlock, size_t originalSize, size_t newSize)
 {
-	ScriptSystem *self = static_cast<ScriptSystem*>(userData);
-
-	if (newSize)
-	{
-		if (newSize <= originalSize)
-		{
-			return originalBlock;
-		}
-		else
-		{
-			// always succeeds
-			void *newBlock = self->Allocate(newSize);
-
-			if (originalSize > 0)
-			{
-				memcpy(newBlock, originalBlock, originalSize);
-			}
+	FUNCTION_PROFILER(gEnv->pSystem, PROFILE_SCRIPT);
 
-			return newBlock;
-		}
-	}
-	else
-	{
-		self->Deallocate(originalBlock);
+	ScriptSystem *self = static_cast<ScriptSystem*>(userData);
 
-		return nullptr;
-	}
+	return self->m_allocator.Reallocate(originalBlock, originalSize, newSize);
 }
 
 void ScriptSystem::OnDumpStateCmd(IConsoleCmdArgs *pArgs)
@@ -1115,3 +1247,11 @@ void ScriptSystem::OnGarbageCollectCmd(IConsoleCmdArgs *pArgs)
 {
 	gEnv->pScriptSystem->ForceGarbageCollection();
 }
+
+void ScriptSystem::OnMemoryStatsCmd(IConsoleCmdArgs *pArgs)
+{
+	const ScriptAllocator & allocator = static_cast<ScriptSystem*>(gEnv->pScriptSystem)->m_allocator;
+
+	CryLogAlways("Lua memory: %zu KiB live, %zu KiB peak, %zu KiB in small object pages",
+		allocator.GetLiveSize() / 1024, allocator.GetPeakSize() / 1024, allocator.GetPooledSize() / 1024);
+}
@@ -1,10 +1,14 @@
 #pragma once
 
+#include <stdint.h>
 #include <string>
 #include <vector>
+#include <unordered_map>
 
 #include "CryCommon/CryScriptSystem/IScriptSystem.h"
 
+#include "ScriptAllocator.h"
+#include "ScriptTable.h"
 #include "ScriptTimerManager.h"
 #include "ScriptBindings/ScriptBindings.h"
 
@@ -13,10 +17,21 @@ struct IConsoleCmdArgs;
 
 class ScriptSystem : public IScriptSystem
 {
+public:
+	struct VectorKeys
+	{
+		ScriptKey x;
+		ScriptKey y;
+		ScriptKey z;
+	};
+
+private:
+	ScriptAllocator m_allocator;
 	lua_State *m_L = nullptr;
 	int m_funcParamCount = -1;
 	int m_errorHandlerRef = 0;
 	int m_nestedForceReload = 0;
+	VectorKeys m_vectorKeys;
 
 	ScriptTimerManager m_timers;
 	ScriptBindings m_bindings;
@@ -31,14 +46,25 @@ class ScriptSystem : public IScriptSystem
 
 	std::vector<Script> m_scripts;
 
+	struct CompiledScript
+	{
+		std::string contentHash;  // SHA-256 of the source, lowercase hex digits
+		std::string bytecode;
+	};
+
+	// sanitized file name -> bytecode of its last known content
+	std::unordered_map<std::string, CompiledScript> m_bytecodeCache;
+	int m_bytecodeCacheLevel = 0;
+
 public:
 	ScriptSystem();
 	~ScriptSystem();
 
 	void Init();
 
+	// from the Lua allocator pool, never fails
 	void *Allocate(size_t size);
-	void Deallocate(void *block);
+	void Deallocate(void *block, size_t size);
 
 	void PushAny(const ScriptAnyValue & any);
 	void PushVec3(const Vec3 & vec);
@@ -49,6 +75,15 @@ public:
 	bool ToAny(ScriptAnyValue & any, int index);
 	bool ToVec3(Vec3 & vec, int index);
 
+	// the key stays valid until the script system is destroyed
+	ScriptKey InternKey(const char *key);
+	void PushKey(ScriptKey key);
+
+	const VectorKeys & GetVectorKeys() const
+	{
+		return m_vectorKeys;
+	}
+
 	ScriptTimerManager & GetScriptTimerManager()
 	{
 		return m_timers;
@@ -114,6 +149,8 @@ public:
 	int GetStackSize() override;
 	uint32_t GetScriptAllocSize() override;
 
+	IScriptRecordSchema *CreateRecordSchema(const ScriptRecordField *fields, int fieldCount) override;
+
 private:
 	void LuaInit();
 	void LuaClose();
@@ -121,6 +158,11 @@ private:
 	void LuaGarbageCollectFull();
 	bool LuaCall(int paramCount, int resultCount);
 
+	bool CompileBuffer(const char *buffer, size_t bufferSize, const char *bufferDescription);
+	bool CompileFile(const char *fileName, const char *content, size_t contentSize, const char *description);
+	void ReadBytecodeFile(const std::string & sanitizedName, CompiledScript & compiled);
+	void WriteBytecodeFile(const std::string & sanitizedName, const CompiledScript & compiled);
+
 	bool AddToScripts(const char *fileName);
 	bool RemoveFromScripts(const char *fileName);
 
@@ -132,4 +174,5 @@ private:
 	static void OnDumpStateCmd(IConsoleCmdArgs *pArgs);
 	static void OnDumpScriptsCmd(IConsoleCmdArgs *pArgs);
 	static void OnGarbageCollectCmd(IConsoleCmdArgs *pArgs);
+	static void OnMemoryStatsCmd(IConsoleCmdArgs *pArgs);
 };
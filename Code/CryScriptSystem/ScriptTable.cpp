@@ -79,6 +79,23 @@ void ScriptTable::PushRef()
 	}
 }
 
+ScriptRecordSchema::ScriptRecordSchema(ScriptSystem *pSS, const ScriptRecordField *fields, int fieldCount)
+{
+	m_fields.resize(fieldCount);
+
+	for (int i = 0; i < fieldCount; i++)
+	{
+		m_fields[i].key = pSS->InternKey(fields[i].key);
+		m_fields[i].type = fields[i].type;
+		m_fields[i].offset = fields[i].offset;
+	}
+}
+
+void ScriptRecordSchema::Release()
+{
+	delete this;
+}
+
 void ScriptTable::SetMetatable(IScriptTable *pMetatable)
 {
 	// -2
@@ -92,6 +109,148 @@ void ScriptTable::SetMetatable(IScriptTable *pMetatable)
 	lua_pop(m_L, 1);
 }
 
+void ScriptTable::SetValueAny(ScriptKey key, const ScriptAnyValue & any, bool isChain)
+{
+	const int top = lua_gettop(m_L);
+
+	if (!isChain)
+		PushRef();
+
+	if (any.type == ANY_TVECTOR)
+	{
+		m_pSS->PushKey(key);
+		lua_gettable(m_L, -2);
+
+		if (RefillVec3(any.vec3))
+		{
+			lua_settop(m_L, top);
+
+			return;
+		}
+
+		// pop key value
+		lua_pop(m_L, 1);
+	}
+
+	m_pSS->PushKey(key);
+	m_pSS->PushAny(any);
+	lua_rawset(m_L, -3);
+
+	lua_settop(m_L, top);
+}
+
+void ScriptTable::FillRecord(const IScriptRecordSchema *pSchema, const void *record, bool isChain)
+{
+	FUNCTION_PROFILER(gEnv->pSystem, PROFILE_SCRIPT);
+
+	const int top = lua_gettop(m_L);
+
+	if (!isChain)
+		PushRef();
+
+	const int tableIndex = lua_gettop(m_L);
+
+	// schemas are only created by the script system
+	const ScriptRecordSchema *pRecordSchema = static_cast<const ScriptRecordSchema*>(pSchema);
+
+	for (const ScriptRecordSchema::Field & field : pRecordSchema->GetFields())
+	{
+		const void *value = static_cast<const unsigned char*>(record) + field.offset;
+
+		switch (field.type)
+		{
+			case ScriptRecordFieldType::BOOL:
+			{
+				m_pSS->PushKey(field.key);
+				lua_pushboolean(m_L, *static_cast<const bool*>(value));
+				break;
+			}
+			case ScriptRecordFieldType::INT:
+			{
+				m_pSS->PushKey(field.key);
+				lua_pushnumber(m_L, *static_cast<const int*>(value));
+				break;
+			}
+			case ScriptRecordFieldType::FLOAT:
+			{
+				m_pSS->PushKey(field.key);
+				lua_pushnumber(m_L, *static_cast<const float*>(value));
+				break;
+			}
+			case ScriptRecordFieldType::HANDLE:
+			{
+				m_pSS->PushKey(field.key);
+				lua_pushlightuserdata(m_L, ScriptHandle(*static_cast<const int*>(value)).ptr);
+				break;
+			}
+			case ScriptRecordFieldType::VEC3:
+			{
+				const Vec3 & vec = *static_cast<const Vec3*>(value);
+
+				m_pSS->PushKey(field.key);
+				lua_gettable(m_L, tableIndex);
+
+				const bool isRefilled = RefillVec3(vec);
+
+				// pop key value
+				lua_pop(m_L, 1);
+
+				if (isRefilled)
+				{
+					continue;
+				}
+
+				m_pSS->PushKey(field.key);
+				m_pSS->PushVec3(vec);
+				break;
+			}
+		}
+
+		lua_rawset(m_L, tableIndex);
+	}
+
+	lua_settop(m_L, top);
+}
+
+bool ScriptTable::RefillVec3(const Vec3 & vec)
+{
+	// the existing value is on top of the stack
+	if (lua_type(m_L, -1) != LUA_TTABLE)
+	{
+		return false;
+	}
+
+	const ScriptSystem::VectorKeys & keys = m_pSS->GetVectorKeys();
+
+	m_pSS->PushKey(keys.x);
+	lua_gettable(m_L, -2);
+
+	const bool isNumber = (lua_isnumber(m_L, -1) != 0);
+
+	// pop x value
+	lua_pop(m_L, 1);
+
+	if (!isNumber)
+	{
+		return false;
+	}
+
+	// assume it's a vector, just fill it with new vector values
+	m_pSS->PushKey(keys.x);
+	lua_pushnumber(m_L, vec.x);
+	lua_settable(m_L, -3);
+
+	m_pSS->PushKey(keys.y);
+	lua_pushnumber(m_L, vec.y);
+	lua_settable(m_L, -3);
+
+	m_pSS->PushKey(keys.z);
+	lua_pushnumber(m_L, vec.z);
+	lua_settable(m_L, -3);
+
+	return true;
+}
+
 //////////////////
 // IScriptTable //
 //////////////////
@@ -160,35 +319,11 @@ void ScriptTable::SetValueAny(const char *key, const ScriptAnyValue & any, bool
 		lua_pushstring(m_L, key);
 		lua_gettable(m_L, -2);
 
-		if (lua_type(m_L, -1) == LUA_TTABLE)
+		if (RefillVec3(any.vec3))
 		{
-			lua_pushstring(m_L, "x");
-			lua_gettable(m_L, -2);
-
-			const bool isNumber = (lua_isnumber(m_L, -1) != 0);
-
-			// pop x value
-			lua_pop(m_L, 1);
+			lua_settop(m_L, top);
 
-			if (isNumber)
-			{
-				// assume it's a vector, just fill it with new vector values
-				lua_pushstring(m_L, "x");
-				lua_pushnumber(m_L, any.vec3.x);
-				lua_settable(m_L, -3);
-
-				lua_pushstring(m_L, "y");
-				lua_pushnumber(m_L, any.vec3.y);
-				lua_settable(m_L, -3);
-
-				lua_pushstring(m_L, "z");
-				lua_pushnumber(m_L, any.vec3.z);
-				lua_settable(m_L, -3);
-
-				lua_settop(m_L, top);
-
-				return;
-			}
+			return;
 		}
 
 		// pop key value
@@ -603,7 +738,7 @@ void ScriptTable::DeallocateTable(ScriptTable *pTable, ScriptSystem *pSS)
 	pTable->~ScriptTable();
 
 	// deallocate memory
-	pSS->Deallocate(pTable);
+	pSS->Deallocate(pTable, sizeof (ScriptTable));
 }
 
 int ScriptTable::StdCFunction(lua_State *L)
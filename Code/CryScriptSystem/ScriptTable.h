@@ -1,11 +1,44 @@
 #pragma once
 
+#include <stddef.h>
+#include <vector>
+
 #include "CryCommon/CryScriptSystem/IScriptSystem.h"
 
 struct lua_State;
 
 class ScriptSystem;
 
+// key string kept in the Lua registry, so it does not need to be hashed again on every use
+struct ScriptKey
+{
+	int ref = 0;
+};
+
+class ScriptRecordSchema : public IScriptRecordSchema
+{
+public:
+	struct Field
+	{
+		ScriptKey key;
+		ScriptRecordFieldType type = ScriptRecordFieldType::INT;
+		size_t offset = 0;
+	};
+
+private:
+	std::vector<Field> m_fields;
+
+public:
+	ScriptRecordSchema(ScriptSystem *pSS, const ScriptRecordField *fields, int fieldCount);
+
+	const std::vector<Field> & GetFields() const
+	{
+		return m_fields;
+	}
+
+	void Release() override;
+};
+
 class ScriptTable : public IScriptTable
 {
 	int m_ref = 0;
@@ -25,6 +58,8 @@ public:
 
 	void SetMetatable(IScriptTable *pMetatable);
 
+	void SetValueAny(ScriptKey key, const ScriptAnyValue & any, bool isChain = false);
+
 	//////////////////
 	// IScriptTable //
 	//////////////////
@@ -66,7 +101,11 @@ public:
 
 	bool GetValueRecursive(const char *path, IScriptTable *pTable) override;
 
+	void FillRecord(const IScriptRecordSchema *pSchema, const void *record, bool isChain = false) override;
+
 private:
+	bool RefillVec3(const Vec3 & vec);
+
 	void CloneTable(int srcTableIndex, int dstTableIndex);
 	void CloneTableRecursive(int srcTableIndex, int dstTableIndex);
 
@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "CryCommon/CrySystem/ISystem.h"
 #include "CryCommon/CrySystem/ITimer.h"
 #include "CryCommon/CryNetwork/ISerialize.h"
@@ -12,12 +14,12 @@ uint64_t ScriptTimerManager::GetCurrentTime()
 
 long ScriptTimerManager::GetFreeTimerSlot()
 {
-	for (size_t i = 0; i < m_timers.size(); i++)
+	if (!m_freeSlots.empty())
 	{
-		if (!m_timers[i].exists)
-		{
-			return i;
-		}
+		const uint16_t slot = m_freeSlots.back();
+		m_freeSlots.pop_back();
+
+		return slot;
 	}
 
 	if (m_timers.size() >= 0xFFFF)  // timer slot is 16-bit unsigned integer
@@ -31,6 +33,39 @@ long ScriptTimerManager::GetFreeTimerSlot()
 	return m_timers.size() - 1;
 }
 
+void ScriptTimerManager::ReleaseTimerSlot(uint16_t slot)
+{
+	m_freeSlots.push_back(slot);
+}
+
+void ScriptTimerManager::QueueTimer(ScriptTimerID timerID)
+{
+	QueuedTimer & queued = m_queue.emplace_back();
+	queued.endTime = m_timers[ToSlot(timerID)].endTime;
+	queued.timerID = timerID;
+
+	std::push_heap(m_queue.begin(), m_queue.end());
+}
+
+void ScriptTimerManager::CompactQueue()
+{
+	const auto isStopped = [this](const QueuedTimer & queued) { return !IsTimerActive(queued.timerID); };
+
+	m_queue.erase(std::remove_if(m_queue.begin(), m_queue.end(), isStopped), m_queue.end());
+
+	std::make_heap(m_queue.begin(), m_queue.end());
+
+	m_stoppedCount = 0;
+}
+
+bool ScriptTimerManager::IsTimerActive(ScriptTimerID timerID)
+{
+	const uint16_t slot = ToSlot(timerID);
+
+	// the slot might be reused by another timer already
+	return slot < m_timers.size() && m_timers[slot].exists && m_timers[slot].serialNumber == ToSerial(timerID);
+}
+
 ScriptTimerID ScriptTimerManager::MakeTimerID(long slot)
 {
 	return (static_cast<uint32_t>(slot) << 16) | m_timers[slot].serialNumber;
@@ -75,6 +110,8 @@ void ScriptTimerManager::TriggerTimer(ScriptTimerID timerID)
 	m_timers[slot].pFunction = nullptr;
 	m_timers[slot].pData = nullptr;
 
+	ReleaseTimerSlot(slot);
+
 	if (pFunction)
 	{
 		if (pData)
@@ -131,15 +168,27 @@ void ScriptTimerManager::Update()
 
 	const uint64_t currentTime = GetCurrentTime();
 
-	for (size_t i = 0; i < m_timers.size(); i++)
+	// timers added by the callbacks are triggered in the next update at the earliest
+	m_expired.clear();
+
+	while (!m_queue.empty() && currentTime >= m_queue.front().endTime)
 	{
-		if (m_timers[i].exists && currentTime >= m_timers[i].endTime)
-		{
-			const ScriptTimerID timerID = MakeTimerID(i);
+		std::pop_heap(m_queue.begin(), m_queue.end());
 
-			TriggerTimer(timerID);
+		m_expired.push_back(m_queue.back());
+		m_queue.pop_back();
+	}
 
-			CryLog("[Script] Timer TICK 0x%08x", timerID);
+	for (const QueuedTimer & expired : m_expired)
+	{
+		// a callback can stop other expired timers
+		if (IsTimerActive(expired.timerID))
+		{
+			TriggerTimer(expired.timerID);
+		}
+		else if (m_stoppedCount > 0)
+		{
+			m_stoppedCount--;
 		}
 	}
 }
@@ -152,6 +201,9 @@ void ScriptTimerManager::Reset()
 	}
 
 	m_timers.clear();
+	m_freeSlots.clear();
+	m_queue.clear();
+	m_stoppedCount = 0;
 }
 
 ScriptTimerID ScriptTimerManager::AddTimer(uint64_t milliseconds, HSCRIPTFUNCTION pFunction, IScriptTable *pData)
@@ -178,6 +230,8 @@ ScriptTimerID ScriptTimerManager::AddTimer(uint64_t milliseconds, HSCRIPTFUNCTIO
 
 	const ScriptTimerID timerID = MakeTimerID(slot);
 
+	QueueTimer(timerID);
+
 	CryLog("[Script] Timer ADD  0x%08x | %8llu ms | 0x%p", timerID, milliseconds, pFunction);
 
 	return timerID;
@@ -207,6 +261,8 @@ ScriptTimerID ScriptTimerManager::AddTimer(uint64_t milliseconds, const char *fu
 
 	const ScriptTimerID timerID = MakeTimerID(slot);
 
+	QueueTimer(timerID);
+
 	CryLog("[Script] Timer ADD  0x%08x | %8llu ms | %s", timerID, milliseconds, functionName);
 
 	return timerID;
@@ -223,6 +279,13 @@ void ScriptTimerManager::StopTimer(ScriptTimerID timerID)
 		if (timer.exists && timer.serialNumber == ToSerial(timerID))
 		{
 			DestroyTimer(timer);
+			ReleaseTimerSlot(slot);
+
+			// do not let the queue grow with stopped timers that expire far in the future
+			if (++m_stoppedCount > 64 && m_stoppedCount > m_queue.size() / 2)
+			{
+				CompactQueue();
+			}
 
 			CryLog("[Script] Timer STOP 0x%08x", timerID);
 		}
@@ -293,6 +356,14 @@ void ScriptTimerManager::Serialize(ISerialize *pSer)
 			// timer
 			ser.EndGroup();
 		}
+
+		for (size_t slot = 0; slot < m_timers.size(); slot++)
+		{
+			if (m_timers[slot].exists)
+				QueueTimer(MakeTimerID(slot));
+			else
+				ReleaseTimerSlot(static_cast<uint16_t>(slot));
+		}
 	}
 	else
 	{
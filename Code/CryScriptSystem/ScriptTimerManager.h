@@ -23,11 +23,31 @@ class ScriptTimerManager
 		std::string functionName;  // alternative to pFunction
 	};
 
+	struct QueuedTimer
+	{
+		uint64_t endTime = 0;
+		ScriptTimerID timerID = 0;
+
+		// min-heap
+		bool operator<(const QueuedTimer & other) const { return this->endTime > other.endTime; }
+	};
+
 	IScriptSystem *m_pSS = nullptr;
 	std::vector<Timer> m_timers;
+	std::vector<uint16_t> m_freeSlots;
+
+	// stopped timers are left in the queue until they expire or there are too many of them
+	std::vector<QueuedTimer> m_queue;
+	std::vector<QueuedTimer> m_expired;
+	size_t m_stoppedCount = 0;
 
 	uint64_t GetCurrentTime();
 	long GetFreeTimerSlot();
+	void ReleaseTimerSlot(uint16_t slot);
+
+	void QueueTimer(ScriptTimerID timerID);
+	void CompactQueue();
+	bool IsTimerActive(ScriptTimerID timerID);
 
 	ScriptTimerID MakeTimerID(long slot);
 	uint16_t ToSlot(ScriptTimerID timerID);
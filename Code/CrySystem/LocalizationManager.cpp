@@ -316,6 +316,40 @@ static void ExpandNewlineInPlace(String& text)
 	text.resize(text.length() - (srcIt - dstIt));
 }
 
+template<typename T>
+static std::uint32_t HashLabelName(std::basic_string_view<T> name)
+{
+	// FNV-1a of the lowercase name
+	std::uint32_t hash = 2166136261;
+
+	for (const T ch : name)
+	{
+		hash ^= static_cast<unsigned char>(StringTools::ToLowerChar(ch));
+		hash *= 16777619;
+	}
+
+	return hash;
+}
+
+template<typename T>
+static bool IsLabelName(const std::string& loweredName, std::basic_string_view<T> name)
+{
+	if (loweredName.length() != name.length())
+	{
+		return false;
+	}
+
+	for (std::size_t i = 0; i < name.length(); i++)
+	{
+		if (static_cast<unsigned char>(loweredName[i]) != static_cast<unsigned char>(StringTools::ToLowerChar(name[i])))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
 LocalizationManager::LocalizationManager()
 {
 }
@@ -351,23 +385,20 @@ bool LocalizationManager::Add(Label&& label, bool keepExisting)
 	ExpandNewlineInPlace(label.localizedText);
 	ExpandNewlineInPlace(label.localizedSubtitle);
 
-	// binary search
-	const auto it = std::lower_bound(m_language.labels.begin(), m_language.labels.end(), label.name,
-		[](const Label& label, const std::string& name)
-		{
-			return label.name < name;
-		}
-	);
+	const std::uint32_t hash = HashLabelName(std::string_view(label.name));
+	const std::size_t index = FindLabelIndex(std::string_view(label.name), hash);
 
-	if (it == m_language.labels.end() || it->name != label.name)
+	if (index == std::string::npos)
 	{
-		m_language.labels.insert(it, std::move(label));
+		m_language.labels.emplace_back(std::move(label));
+
+		InsertLabelSlot(hash, m_language.labels.size() - 1);
 
 		return true;
 	}
 	else if (!keepExisting)
 	{
-		*it = std::move(label);
+		m_language.labels[index] = std::move(label);
 
 		return true;
 	}
@@ -379,20 +410,23 @@ bool LocalizationManager::Add(Label&& label, bool keepExisting)
 
 const LocalizationManager::Label* LocalizationManager::FindLabel(std::string_view name) const
 {
-	std::string loweredName;
-	StringTools::AppendTo(loweredName, name);
-	StringTools::ToLowerInPlace(loweredName);
-
-	return this->FindLabelImpl(loweredName);
+	return this->FindLabelImpl(name);
 }
 
 const LocalizationManager::Label* LocalizationManager::FindLabel(std::wstring_view name) const
 {
-	std::string loweredName;
-	StringTools::AppendTo(loweredName, name);
-	StringTools::ToLowerInPlace(loweredName);
+	const bool isASCII = std::all_of(name.begin(), name.end(), [](wchar_t ch) { return ch < 0x80; });
+
+	if (isASCII)
+	{
+		return this->FindLabelImpl(name);
+	}
+
+	// label names are stored in UTF-8
+	std::string convertedName;
+	StringTools::AppendTo(convertedName, name);
 
-	return this->FindLabelImpl(loweredName);
+	return this->FindLabelImpl(std::string_view(convertedName));
 }
 
 std::string LocalizationManager::Localize(std::string_view text) const
@@ -512,6 +546,8 @@ bool LocalizationManager::LoadExcelXmlSpreadsheet(const char* filename, bool rel
 	if (!wasLoaded)
 	{
 		m_language.labels.reserve(m_language.labels.size() + (rowCount - row));
+
+		RebuildLabelSlots(m_language.labels.size() + (rowCount - row));
 	}
 
 	for (; row < rowCount; row++)
@@ -526,6 +562,16 @@ bool LocalizationManager::LoadExcelXmlSpreadsheet(const char* filename, bool rel
 		}
 	}
 
+	// new labels are appended, sort them once the whole file is loaded
+	std::sort(m_language.labels.begin(), m_language.labels.end(),
+		[](const Label& a, const Label& b)
+		{
+			return a.name < b.name;
+		}
+	);
+
+	RebuildLabelSlots(m_language.labels.size());
+
 	if (!wasLoaded)
 	{
 		m_filenames.emplace_back(loweredFilename);
@@ -539,6 +585,7 @@ bool LocalizationManager::LoadExcelXmlSpreadsheet(const char* filename, bool rel
 void LocalizationManager::FreeData()
 {
 	m_language = {};
+	m_labelSlots.clear();
 	m_filenames.clear();
 }
 
@@ -780,24 +827,19 @@ void LocalizationManager::LocalizeDuration(int seconds, wstring& result)
 	LocalizeString(buffer, result);
 }
 
-const LocalizationManager::Label* LocalizationManager::FindLabelImpl(std::string_view loweredName) const
+template<typename T>
+const LocalizationManager::Label* LocalizationManager::FindLabelImpl(std::basic_string_view<T> name) const
 {
-	if (loweredName.length() > 0 && loweredName[0] == '@')
+	if (name.length() > 0 && name[0] == '@')
 	{
-		loweredName.remove_prefix(1);
+		name.remove_prefix(1);
 	}
 
-	// binary search
-	const auto it = std::lower_bound(m_language.labels.begin(), m_language.labels.end(), loweredName,
-		[](const Label& label, const std::string_view& loweredName)
-		{
-			return label.name < loweredName;
-		}
-	);
+	const std::size_t index = FindLabelIndex(name, HashLabelName(name));
 
-	if (it != m_language.labels.end() && it->name == loweredName)
+	if (index != std::string::npos)
 	{
-		return &(*it);
+		return &m_language.labels[index];
 	}
 	else
 	{
@@ -805,6 +847,80 @@ const LocalizationManager::Label* LocalizationManager::FindLabelImpl(std::string
 	}
 }
 
+template<typename T>
+std::size_t LocalizationManager::FindLabelIndex(std::basic_string_view<T> name, std::uint32_t hash) const
+{
+	if (m_labelSlots.empty())
+	{
+		return std::string::npos;
+	}
+
+	const std::size_t mask = m_labelSlots.size() - 1;
+
+	for (std::size_t i = hash & mask; m_labelSlots[i].index != 0; i = (i + 1) & mask)
+	{
+		const LabelSlot& slot = m_labelSlots[i];
+		const std::size_t index = slot.index - 1;
+
+		if (slot.hash == hash && IsLabelName(m_language.labels[index].name, name))
+		{
+			return index;
+		}
+	}
+
+	return std::string::npos;
+}
+
+void LocalizationManager::InsertLabelSlot(std::uint32_t hash, std::size_t index)
+{
+	// keep at least half of the slots empty
+	if ((index + 1) * 2 > m_labelSlots.size())
+	{
+		RebuildLabelSlots(index + 1);
+		return;
+	}
+
+	const std::size_t mask = m_labelSlots.size() - 1;
+
+	std::size_t i = hash & mask;
+	while (m_labelSlots[i].index != 0)
+	{
+		i = (i + 1) & mask;
+	}
+
+	m_labelSlots[i].hash = hash;
+	m_labelSlots[i].index = static_cast<std::uint32_t>(index + 1);
+}
+
+void LocalizationManager::RebuildLabelSlots(std::size_t labelCount)
+{
+	labelCount = std::max(labelCount, m_language.labels.size());
+
+	std::size_t slotCount = 256;
+	while (slotCount < labelCount * 2)
+	{
+		slotCount *= 2;
+	}
+
+	m_labelSlots.assign(slotCount, LabelSlot());
+
+	const std::size_t mask = slotCount - 1;
+
+	for (std::size_t index = 0; index < m_language.labels.size(); index++)
+	{
+		const std::uint32_t hash = HashLabelName(std::string_view(m_language.labels[index].name));
+
+		std::size_t i = hash & mask;
+		while (m_labelSlots[i].index != 0)
+		{
+			i = (i + 1) & mask;
+		}
+
+		m_labelSlots[i].hash = hash;
+		m_labelSlots[i].index = static_cast<std::uint32_t>(index + 1);
+	}
+}
+
 template<typename NameStringView, typename ResultString>
 bool LocalizationManager::LocalizeControlCode(NameStringView name, ResultString& result) const
 {
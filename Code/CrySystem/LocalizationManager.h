@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -38,7 +39,14 @@ public:
 	};
 
 private:
+	struct LabelSlot
+	{
+		std::uint32_t hash = 0;
+		std::uint32_t index = 0;  // label index + 1, zero if the slot is empty
+	};
+
 	Language m_language;
+	std::vector<LabelSlot> m_labelSlots;  // open addressing, case-insensitive hash of the label name
 	std::vector<std::string> m_filenames;
 
 	static LocalizationManager s_globalInstance;
@@ -114,7 +122,14 @@ public:
 	////////////////////////////////////////////////////////////////////////////////
 
 private:
-	const Label* FindLabelImpl(std::string_view loweredName) const;
+	template<typename T>
+	const Label* FindLabelImpl(std::basic_string_view<T> name) const;
+
+	template<typename T>
+	std::size_t FindLabelIndex(std::basic_string_view<T> name, std::uint32_t hash) const;
+
+	void InsertLabelSlot(std::uint32_t hash, std::size_t index);
+	void RebuildLabelSlots(std::size_t labelCount);
 
 	template<typename NameStringView, typename ResultString>
 	bool LocalizeControlCode(NameStringView name, ResultString& result) const;
@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <chrono>
 #include <cstring>
 
 #include "CryCommon/CrySystem/CryColorCode.h"
@@ -12,6 +13,29 @@
 
 Logger Logger::s_globalInstance;
 
+namespace
+{
+	// the crash handler flushes without waiting from any thread, maybe one that already holds a lock
+	// calling try_lock on a mutex owned by the calling thread is undefined
+	thread_local bool t_hasFileWriteLock = false;
+	thread_local bool t_hasFileBufferLock = false;
+
+	struct ThreadLockFlag
+	{
+		bool& flag;
+
+		explicit ThreadLockFlag(bool& flag) : flag(flag)
+		{
+			flag = true;
+		}
+
+		~ThreadLockFlag()
+		{
+			flag = false;
+		}
+	};
+}
+
 Logger::Logger()
 {
 	m_mainThreadID = std::this_thread::get_id();
@@ -19,10 +43,16 @@ Logger::Logger()
 
 Logger::~Logger()
 {
+	CloseFile();
 }
 
 void Logger::OnUpdate()
 {
+	if (m_cvars.flushInterval)
+	{
+		m_flushInterval = m_cvars.flushInterval->GetIVal();
+	}
+
 	std::lock_guard lock(m_mutex);
 
 	for (const Message& message : m_messages)
@@ -97,21 +127,61 @@ void Logger::OpenFile(const std::filesystem::path& filePath)
 		throw StringTools::SysErrorErrnoFormat("Failed to open log file: %s", filePathString.c_str());
 	}
 
+	CloseFile();
+
 	m_file = std::move(file);
 	m_filePath = filePath;
 	m_fileName = filePath.filename().string();
 
+	StartFileWriter();
+
 	LogAlways("BackupNameAttachment=\"%s\"", FormatPrefix(" Date(%Y %m %d) Time(%H %M %S)").c_str());
 	LogAlways("");
 }
 
 void Logger::CloseFile()
 {
+	StopFileWriter();
+	Flush();
+
 	m_file.reset();
 	m_filePath.clear();
 	m_fileName.clear();
 }
 
+void Logger::Flush(bool wait)
+{
+	std::unique_lock writeLock(m_fileWriteMutex, std::defer_lock);
+
+	if (wait)
+		writeLock.lock();
+	else if (t_hasFileWriteLock || !writeLock.try_lock())
+		return;
+
+	ThreadLockFlag writeLockFlag(t_hasFileWriteLock);
+
+	{
+		std::unique_lock bufferLock(m_fileBufferMutex, std::defer_lock);
+
+		if (wait)
+			bufferLock.lock();
+		else if (t_hasFileBufferLock || !bufferLock.try_lock())
+			return;
+
+		ThreadLockFlag bufferLockFlag(t_hasFileBufferLock);
+
+		// keep both buffers allocated
+		m_fileWriteBuffer.clear();
+		std::swap(m_fileWriteBuffer, m_fileBuffer);
+	}
+
+	if (m_file && !m_fileWriteBuffer.empty())
+	{
+		std::fwrite(m_fileWriteBuffer.c_str(), 1, m_fileWriteBuffer.length(), m_file.get());
+		std::fflush(m_file.get());
+	}
+}
+
 void Logger::SetPrefix(const std::string_view& prefix)
 {
 	m_prefix = prefix;
@@ -415,6 +485,13 @@ void Logger::RegisterConsoleVariables()
 		"  %T = Equivalent to \"%H:%M:%S\" (the ISO 8601 time format)\n"
 		"  %t = Thread ID where the message was logged"
 	);
+
+	m_cvars.flushInterval = pConsole->RegisterInt("log_FlushInterval", DEFAULT_FLUSH_INTERVAL, VF_NOT_NET_SYNCED,
+		"Defines how often the log file is written in milliseconds.\n"
+		"Errors are always written immediately.\n"
+		"Usage: log_FlushInterval 200\n"
+		"  0 = Write every message immediately."
+	);
 }
 
 void Logger::UnregisterConsoleVariables()
@@ -626,34 +703,54 @@ void Logger::WriteMessageToFile(const Message& message)
 		return;
 	}
 
-	std::string buffer;
-	buffer.reserve(message.content.length() + 1);
+	bool isWriterRunning = false;
+	std::size_t bufferSize = 0;
 
-	for (std::size_t i = 0; i < message.content.length(); i++)
 	{
-		if (message.content[i] == '$')
+		std::lock_guard lock(m_fileBufferMutex);
+		ThreadLockFlag lockFlag(t_hasFileBufferLock);
+
+		m_fileBuffer += message.prefix;
+
+		const std::size_t contentPos = m_fileBuffer.length();
+
+		for (std::size_t i = 0; i < message.content.length(); i++)
 		{
-			// drop color codes
-			// and convert "$$" to "$"
-			if ((i+1) < message.content.length() && message.content[++i] == '$')
+			if (message.content[i] == '$')
 			{
-				buffer += '$';
+				// drop color codes
+				// and convert "$$" to "$"
+				if ((i+1) < message.content.length() && message.content[++i] == '$')
+				{
+					m_fileBuffer += '$';
+				}
+			}
+			else
+			{
+				m_fileBuffer += message.content[i];
 			}
 		}
-		else
+
+		if (m_fileBuffer.length() == contentPos || m_fileBuffer.back() != '\n')
 		{
-			buffer += message.content[i];
+			m_fileBuffer += '\n';
 		}
+
+		isWriterRunning = m_isFileWriterRunning;
+		bufferSize = m_fileBuffer.length();
 	}
 
-	if (buffer.empty() || buffer.back() != '\n')
+	const bool isError = (message.type == ILog::eError || message.type == ILog::eErrorAlways);
+
+	// the writer thread cannot keep up when the buffer is full, so let the caller wait
+	if (!isWriterRunning || isError || m_flushInterval <= 0 || bufferSize >= FILE_BUFFER_MAX_SIZE)
 	{
-		buffer += '\n';
+		Flush();
+	}
+	else if (bufferSize >= FILE_BUFFER_WAKE_SIZE)
+	{
+		m_fileWriterCV.notify_one();
 	}
-
-	std::fwrite(message.prefix.c_str(), 1, message.prefix.length(), m_file.get());
-	std::fwrite(buffer.c_str(), 1, buffer.length(), m_file.get());
-	std::fflush(m_file.get());
 
 	for (ILogCallback* callback : m_callbacks)
 	{
@@ -682,3 +779,56 @@ void Logger::WriteMessageToConsole(const Message& message)
 		callback->OnWriteToConsole(message.content.c_str(), true);
 	}
 }
+
+void Logger::StartFileWriter()
+{
+	{
+		std::lock_guard lock(m_fileBufferMutex);
+		ThreadLockFlag lockFlag(t_hasFileBufferLock);
+
+		m_isFileWriterRunning = true;
+	}
+
+	m_fileWriterThread = std::thread(&Logger::FileWriterLoop, this);
+}
+
+void Logger::StopFileWriter()
+{
+	{
+		std::lock_guard lock(m_fileBufferMutex);
+		ThreadLockFlag lockFlag(t_hasFileBufferLock);
+
+		m_isFileWriterRunning = false;
+	}
+
+	m_fileWriterCV.notify_one();
+
+	if (m_fileWriterThread.joinable())
+	{
+		m_fileWriterThread.join();
+	}
+}
+
+void Logger::FileWriterLoop()
+{
+	std::unique_lock lock(m_fileBufferMutex);
+	t_hasFileBufferLock = true;
+
+	while (m_isFileWriterRunning)
+	{
+		const int interval = std::max(m_flushInterval.load(), 1);
+
+		m_fileWriterCV.wait_for(lock, std::chrono::milliseconds(interval));
+
+		if (!m_fileBuffer.empty())
+		{
+			t_hasFileBufferLock = false;
+			lock.unlock();
+			Flush();
+			lock.lock();
+			t_hasFileBufferLock = true;
+		}
+	}
+
+	t_hasFileBufferLock = false;
+}
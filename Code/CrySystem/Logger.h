@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
 #include <cstdio>
 #include <filesystem>
 #include <memory>
@@ -39,6 +41,10 @@ class Logger final : public ILog
 
 	using FileHandle = std::unique_ptr<std::FILE, FileHandleDeleter>;
 
+	static constexpr int DEFAULT_FLUSH_INTERVAL = 200;  // milliseconds
+	static constexpr std::size_t FILE_BUFFER_WAKE_SIZE = 64 * 1024;
+	static constexpr std::size_t FILE_BUFFER_MAX_SIZE = 4 * 1024 * 1024;
+
 	int m_verbosity = 0;
 	FileHandle m_file;
 	std::filesystem::path m_filePath;
@@ -50,6 +56,7 @@ class Logger final : public ILog
 		ICVar* verbosity = nullptr;
 		ICVar* fileVerbosity = nullptr;
 		ICVar* prefix = nullptr;
+		ICVar* flushInterval = nullptr;
 	};
 
 	CVars m_cvars;
@@ -58,6 +65,16 @@ class Logger final : public ILog
 	std::vector<Message> m_messages;
 	std::vector<ILogCallback*> m_callbacks;
 
+	// log file content is batched and written by a separate thread
+	std::string m_fileBuffer;
+	std::mutex m_fileBufferMutex;
+	std::condition_variable m_fileWriterCV;
+	std::thread m_fileWriterThread;
+	bool m_isFileWriterRunning = false;
+	std::atomic<int> m_flushInterval = DEFAULT_FLUSH_INTERVAL;
+	std::string m_fileWriteBuffer;
+	std::mutex m_fileWriteMutex;
+
 	static Logger s_globalInstance;
 
 public:
@@ -87,6 +104,10 @@ public:
 
 	void SetPrefix(const std::string_view& prefix);
 
+	// thread-safe, writes pending messages to the log file
+	// without waiting, nothing is written if another thread is writing right now
+	void Flush(bool wait = true);
+
 	static std::string FormatPrefix(const std::string_view& prefix);
 
 	void LogAlways(const char* format, ...);
@@ -137,5 +158,9 @@ private:
 	void WriteMessage(const Message& message);
 
 	void WriteMessageToFile(const Message& message);
+
+	void StartFileWriter();
+	void StopFileWriter();
+	void FileWriterLoop();
 	void WriteMessageToConsole(const Message& message);
 };
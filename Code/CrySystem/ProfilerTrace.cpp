@@ -0,0 +1,473 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <thread>
+
+#include "CryCommon/CrySystem/ISystem.h"
+#include "CryCommon/CrySystem/IConsole.h"
+#include "CryCommon/CrySystem/ICryPak.h"
+#include "Library/StringTools.h"
+#include "Library/WinAPI.h"
+
+#include "ProfilerTrace.h"
+
+ProfilerTrace ProfilerTrace::s_globalInstance;
+
+namespace
+{
+	constexpr int DEFAULT_FRAME_COUNT = 60;
+	constexpr int MAX_FRAME_COUNT = 10000;
+	constexpr const char* DEFAULT_FILE_NAME = "ProfilerTrace.json";
+
+	// pseudo-subsystem of the frame events
+	constexpr int SUBSYSTEM_FRAME = PROFILE_LAST_SUBSYSTEM;
+
+	const char* SUBSYSTEM_NAMES[] = {
+		"Any",
+		"Renderer",
+		"3DEngine",
+		"Particle",
+		"AI",
+		"Animation",
+		"Movie",
+		"Entity",
+		"Font",
+		"Network",
+		"Physics",
+		"Script",
+		"Sound",
+		"Music",
+		"Editor",
+		"System",
+		"Game",
+		"Input",
+		"Sync",
+		"NetworkTraffic",
+		"Frame",
+	};
+
+	static_assert(std::size(SUBSYSTEM_NAMES) == SUBSYSTEM_FRAME + 1);
+
+	// profiler sections are strictly nested in each thread
+	struct SectionEntry
+	{
+		int64_t begin;
+		unsigned int state;
+		bool chain;
+	};
+
+	constexpr int MAX_SECTION_DEPTH = 256;
+
+	struct SectionStack
+	{
+		SectionEntry entries[MAX_SECTION_DEPTH];
+		int depth;
+	};
+
+	thread_local SectionStack t_sections;
+
+	int64_t Now()
+	{
+		const auto now = std::chrono::steady_clock::now().time_since_epoch();
+
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+	}
+
+	unsigned long GetCurrentThreadID()
+	{
+		const auto id = std::this_thread::get_id();
+
+		unsigned long raw_id = 0;
+		static_assert(sizeof(id) == sizeof(raw_id));
+
+		std::memcpy(&raw_id, &id, sizeof(raw_id));
+
+		return raw_id;
+	}
+
+	void AppendJSONString(std::string& result, const char* text)
+	{
+		result += '"';
+
+		for (; *text; text++)
+		{
+			const char ch = *text;
+
+			if (ch == '"' || ch == '\\')
+			{
+				result += '\\';
+				result += ch;
+			}
+			else if (static_cast<unsigned char>(ch) < 0x20)
+			{
+				StringTools::FormatTo(result, "\\u%04x", ch);
+			}
+			else
+			{
+				result += ch;
+			}
+		}
+
+		result += '"';
+	}
+}
+
+ProfilerTrace::ProfilerTrace()
+{
+}
+
+ProfilerTrace::~ProfilerTrace()
+{
+}
+
+void ProfilerTrace::OnStartSection(CFrameProfilerSection* pSection)
+{
+	ProfilerTrace& self = s_globalInstance;
+
+	const unsigned int state = self.m_state.load(std::memory_order_acquire);
+	const bool isCapturing = (state & STATE_CAPTURING);
+	const bool chain = (!isCapturing || (state & STATE_CHAIN)) && self.m_pEngineStartSection;
+
+	if (chain)
+	{
+		self.m_pEngineStartSection(pSection);
+	}
+
+	SectionStack& stack = t_sections;
+
+	if (stack.depth < MAX_SECTION_DEPTH)
+	{
+		SectionEntry& entry = stack.entries[stack.depth];
+		entry.begin = isCapturing ? Now() : 0;
+		entry.state = state;
+		entry.chain = chain;
+	}
+
+	stack.depth++;
+}
+
+void ProfilerTrace::OnEndSection(CFrameProfilerSection* pSection)
+{
+	ProfilerTrace& self = s_globalInstance;
+
+	SectionStack& stack = t_sections;
+
+	if (stack.depth <= 0)
+	{
+		// started by the engine profiler before the callbacks were replaced
+		if (self.m_pEngineEndSection)
+		{
+			self.m_pEngineEndSection(pSection);
+		}
+
+		return;
+	}
+
+	stack.depth--;
+
+	if (stack.depth >= MAX_SECTION_DEPTH)
+	{
+		const unsigned int state = self.m_state.load(std::memory_order_acquire);
+
+		if ((!(state & STATE_CAPTURING) || (state & STATE_CHAIN)) && self.m_pEngineEndSection)
+		{
+			self.m_pEngineEndSection(pSection);
+		}
+
+		return;
+	}
+
+	const SectionEntry& entry = stack.entries[stack.depth];
+
+	if (entry.state & STATE_CAPTURING)
+	{
+		const int64_t end = Now();
+
+		// sections still open when the capture is finished are dropped
+		if (self.m_state.load(std::memory_order_relaxed) == entry.state)
+		{
+			const CFrameProfiler* pProfiler = pSection->m_pFrameProfiler;
+
+			self.Record(entry.state, pProfiler->m_name, pProfiler->m_subsystem, entry.begin, end);
+		}
+	}
+
+	if (entry.chain)
+	{
+		self.m_pEngineEndSection(pSection);
+	}
+}
+
+void ProfilerTrace::OnTraceCmd(IConsoleCmdArgs* pArgs)
+{
+	ProfilerTrace& self = s_globalInstance;
+
+	if (self.m_state.load(std::memory_order_relaxed) & STATE_CAPTURING)
+	{
+		CryLogWarning("[ProfilerTrace] Capture is already in progress");
+		return;
+	}
+
+	int frameCount = DEFAULT_FRAME_COUNT;
+	const char* fileName = DEFAULT_FILE_NAME;
+
+	if (pArgs->GetArgCount() > 1)
+	{
+		frameCount = std::atoi(pArgs->GetArg(1));
+	}
+
+	if (pArgs->GetArgCount() > 2)
+	{
+		fileName = pArgs->GetArg(2);
+	}
+
+	if (frameCount <= 0 || frameCount > MAX_FRAME_COUNT)
+	{
+		CryLogWarning("[ProfilerTrace] Invalid number of frames, it must be between 1 and %d", MAX_FRAME_COUNT);
+		return;
+	}
+
+	// relative paths are in the user directory
+	std::filesystem::path filePath = fileName;
+	if (filePath.is_relative())
+	{
+		filePath = std::filesystem::path(gEnv->pCryPak->GetAlias("%USER%")) / filePath;
+	}
+
+	self.Start(frameCount, filePath);
+}
+
+ProfilerTrace::ThreadBuffer* ProfilerTrace::GetThreadBuffer(unsigned int state)
+{
+	static thread_local ThreadBuffer* pBuffer = nullptr;
+
+	if (!pBuffer)
+	{
+		pBuffer = new ThreadBuffer();
+		pBuffer->threadID = GetCurrentThreadID();
+		pBuffer->pNext = m_buffers.load(std::memory_order_relaxed);
+
+		while (!m_buffers.compare_exchange_weak(pBuffer->pNext, pBuffer, std::memory_order_release, std::memory_order_relaxed))
+		{
+		}
+	}
+
+	if (pBuffer->state.load(std::memory_order_relaxed) != state)
+	{
+		// first event of a new capture in this thread
+		if (pBuffer->capacity != m_capacity)
+		{
+			pBuffer->events = std::make_unique<Event[]>(m_capacity);
+			pBuffer->capacity = m_capacity;
+		}
+
+		pBuffer->count.store(0, std::memory_order_relaxed);
+		pBuffer->dropped.store(0, std::memory_order_relaxed);
+		pBuffer->state.store(state, std::memory_order_release);
+	}
+
+	return pBuffer;
+}
+
+void ProfilerTrace::Record(unsigned int state, const char* name, int subsystem, int64_t begin, int64_t end)
+{
+	ThreadBuffer* pBuffer = GetThreadBuffer(state);
+
+	const unsigned int count = pBuffer->count.load(std::memory_order_relaxed);
+
+	if (count >= pBuffer->capacity)
+	{
+		pBuffer->dropped.store(pBuffer->dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		return;
+	}
+
+	Event& event = pBuffer->events[count];
+	event.name = name;
+	event.begin = begin;
+	event.end = end;
+	event.subsystem = subsystem;
+
+	pBuffer->count.store(count + 1, std::memory_order_release);
+}
+
+void ProfilerTrace::Start(int frameCount, const std::filesystem::path& filePath)
+{
+	if (gEnv->callbackStartSection != &OnStartSection)
+	{
+		// installed on the first capture and never removed, sections can still be open in other threads
+		m_pEngineStartSection = gEnv->callbackStartSection;
+		m_pEngineEndSection = gEnv->callbackEndSection;
+
+		gEnv->callbackStartSection = &OnStartSection;
+		gEnv->callbackEndSection = &OnEndSection;
+	}
+
+	m_wasProfilerEnabled = gEnv->bProfilerEnabled;
+	m_capacity = static_cast<unsigned int>(std::max(m_bufferSize, 1024));
+	m_remainingFrames = frameCount;
+	m_filePath = filePath;
+	m_captureStart = Now();
+	m_frameStart = m_captureStart;
+
+	unsigned int state = (m_state.load(std::memory_order_relaxed) & ~(STATE_GENERATION - 1)) + STATE_GENERATION;
+	state |= STATE_CAPTURING;
+
+	if (m_wasProfilerEnabled)
+	{
+		state |= STATE_CHAIN;
+	}
+
+	m_state.store(state, std::memory_order_release);
+
+	gEnv->bProfilerEnabled = true;
+
+	CryLogAlways("[ProfilerTrace] Capturing %d frames", frameCount);
+}
+
+void ProfilerTrace::Stop()
+{
+	const unsigned int state = m_state.load(std::memory_order_relaxed);
+
+	m_state.store(state & ~(STATE_GENERATION - 1), std::memory_order_release);
+
+	gEnv->bProfilerEnabled = m_wasProfilerEnabled;
+
+	Write(state);
+}
+
+void ProfilerTrace::Write(unsigned int state)
+{
+	const int64_t writeStart = Now();
+
+	WinAPI::File file(m_filePath, WinAPI::FileAccess::WRITE_ONLY_CREATE);
+	if (!file)
+	{
+		CryLogWarning("[ProfilerTrace] Failed to open %s", m_filePath.string().c_str());
+		return;
+	}
+
+	std::string buffer;
+	buffer.reserve(1024 * 1024);
+
+	uint64_t eventCount = 0;
+	uint64_t droppedCount = 0;
+	unsigned int threadCount = 0;
+
+	try
+	{
+		file.Resize(0);
+
+		buffer += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+		for (ThreadBuffer* pBuffer = m_buffers.load(std::memory_order_acquire); pBuffer; pBuffer = pBuffer->pNext)
+		{
+			if (pBuffer->state.load(std::memory_order_acquire) != state)
+			{
+				continue;
+			}
+
+			const unsigned int count = pBuffer->count.load(std::memory_order_acquire);
+			const unsigned long tid = pBuffer->threadID;
+
+			StringTools::FormatTo(buffer,
+				"%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%lu,\"args\":{\"name\":",
+				(threadCount > 0) ? ",\n" : "", tid);
+
+			if (tid == m_mainThreadID)
+			{
+				buffer += "\"Main\"}}";
+			}
+			else
+			{
+				StringTools::FormatTo(buffer, "\"Thread %04lx\"}}", tid);
+			}
+
+			for (unsigned int i = 0; i < count; i++)
+			{
+				const Event& event = pBuffer->events[i];
+
+				buffer += ",\n{\"name\":";
+				AppendJSONString(buffer, event.name ? event.name : "?");
+
+				StringTools::FormatTo(buffer, ",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%lu}",
+					SUBSYSTEM_NAMES[std::clamp(event.subsystem, 0, SUBSYSTEM_FRAME)],
+					(event.begin - m_captureStart) / 1000.0,
+					(event.end - event.begin) / 1000.0,
+					tid);
+
+				if (buffer.length() >= 1024 * 1024)
+				{
+					file.Write(buffer);
+					buffer.clear();
+				}
+			}
+
+			eventCount += count;
+			droppedCount += pBuffer->dropped.load(std::memory_order_relaxed);
+			threadCount++;
+		}
+
+		buffer += "\n]}\n";
+
+		file.Write(buffer);
+	}
+	catch (const std::exception& ex)
+	{
+		CryLogWarning("[ProfilerTrace] Failed to write %s: %s", m_filePath.string().c_str(), ex.what());
+		return;
+	}
+
+	const double writeTime = (Now() - writeStart) / 1000000.0;
+
+	CryLogAlways("[ProfilerTrace] Written %llu sections from %u threads to %s in %.1f ms",
+		eventCount, threadCount, m_filePath.string().c_str(), writeTime);
+
+	if (droppedCount > 0)
+	{
+		CryLogWarning("[ProfilerTrace] Dropped %llu sections, increase profile_trace_buffer", droppedCount);
+	}
+}
+
+void ProfilerTrace::Init()
+{
+	m_mainThreadID = GetCurrentThreadID();
+
+	IConsole* pConsole = gEnv->pConsole;
+
+	pConsole->Register("profile_trace_buffer", &m_bufferSize, 65536, VF_NOT_NET_SYNCED,
+		"Maximum number of profiler sections recorded in each thread during one profile_trace capture.");
+
+	pConsole->AddCommand("profile_trace", OnTraceCmd, VF_NOT_NET_SYNCED,
+		"Records FUNCTION_PROFILER sections of all threads and writes them in the Chrome trace event format.\n"
+		"Open the file in chrome://tracing or https://ui.perfetto.dev\n"
+		"Usage: profile_trace [FRAMES] [FILE]\n"
+		"Default is 60 frames to ProfilerTrace.json in the user directory.");
+}
+
+void ProfilerTrace::OnUpdate()
+{
+	const unsigned int state = m_state.load(std::memory_order_relaxed);
+
+	if (!(state & STATE_CAPTURING))
+	{
+		return;
+	}
+
+	const int64_t now = Now();
+
+	Record(state, "Frame", SUBSYSTEM_FRAME, m_frameStart, now);
+
+	m_frameStart = now;
+
+	if (--m_remainingFrames <= 0)
+	{
+		Stop();
+		return;
+	}
+
+	// the engine profiler might have disabled it
+	gEnv->bProfilerEnabled = true;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+
+struct IConsoleCmdArgs;
+class CFrameProfilerSection;
+
+// Records FUNCTION_PROFILER sections of a number of frames and writes them as Chrome trace events
+// The section callbacks are only called while gEnv->bProfilerEnabled is set, so it costs nothing when idle
+class ProfilerTrace
+{
+	struct Event
+	{
+		const char* name = nullptr;
+		int64_t begin = 0;
+		int64_t end = 0;
+		int subsystem = 0;
+	};
+
+	// written only by the owner thread, read by the main thread after the capture is finished
+	struct ThreadBuffer
+	{
+		std::unique_ptr<Event[]> events;
+		unsigned int capacity = 0;
+		std::atomic<unsigned int> count = 0;
+		std::atomic<unsigned int> dropped = 0;
+		std::atomic<unsigned int> state = 0;  // capture state the events belong to
+		unsigned long threadID = 0;
+		ThreadBuffer* pNext = nullptr;
+	};
+
+	enum
+	{
+		STATE_CAPTURING   = (1 << 0),
+		STATE_CHAIN       = (1 << 1),  // engine profiler was running before the capture
+		STATE_GENERATION  = (1 << 2),
+	};
+
+	// generation, chain flag and capturing flag in one word, so section callbacks need a single load
+	std::atomic<unsigned int> m_state = 0;
+	std::atomic<ThreadBuffer*> m_buffers = nullptr;  // never freed, other threads keep pointers to them
+
+	void (*m_pEngineStartSection)(CFrameProfilerSection*) = nullptr;
+	void (*m_pEngineEndSection)(CFrameProfilerSection*) = nullptr;
+	bool m_wasProfilerEnabled = false;
+
+	unsigned long m_mainThreadID = 0;
+	int m_remainingFrames = 0;
+	int64_t m_frameStart = 0;
+	int64_t m_captureStart = 0;
+	std::filesystem::path m_filePath;
+
+	unsigned int m_capacity = 0;  // events per thread in the current capture
+	int m_bufferSize = 0;
+
+	static ProfilerTrace s_globalInstance;
+
+	static void OnStartSection(CFrameProfilerSection* pSection);
+	static void OnEndSection(CFrameProfilerSection* pSection);
+	static void OnTraceCmd(IConsoleCmdArgs* pArgs);
+
+	ThreadBuffer* GetThreadBuffer(unsigned int state);
+	void Record(unsigned int state, const char* name, int subsystem, int64_t begin, int64_t end);
+
+	void Start(int frameCount, const std::filesystem::path& filePath);
+	void Stop();
+	void Write(unsigned int state);
+
+public:
+	ProfilerTrace();
+	~ProfilerTrace();
+
+	// to be removed once we have our own CrySystem
+	static ProfilerTrace& GetInstance()
+	{
+		return s_globalInstance;
+	}
+
+	void Init();
+	void OnUpdate();
+};
@@ -13,6 +13,7 @@
 #include "CrySystem/HardwareMouse.h"
 #include "CrySystem/LocalizationManager.h"
 #include "CrySystem/Logger.h"
+#include "CrySystem/ProfilerTrace.h"
 #include "CrySystem/RandomGenerator.h"
 #include "Library/CrashLogger.h"
 #include "Library/StringTools.h"
@@ -721,7 +722,16 @@ void Launcher::OnInit(ISystem* pSystem)
 	logger.SetVerbosity(verbosity);
 	logger.OpenFile((rootDirPath.empty() ? userDirPath : rootDirPath) / logFileName);
 
-	CrashLogger::Enable([]() -> std::FILE* { return Logger::GetInstance().GetFileHandle(); });
+	CrashLogger::Enable([]() -> std::FILE*
+	{
+		Logger& logger = Logger::GetInstance();
+
+		// the crash might have happened while writing the log
+		const bool wait = false;
+		logger.Flush(wait);
+
+		return logger.GetFileHandle();
+	});
 
 	logger.LogAlways("Log begins at %s", Logger::FormatPrefix("%F %T%z").c_str());
 
@@ -748,6 +758,8 @@ void Launcher::OnInit(ISystem* pSystem)
 	logger.SetPrefix(logPrefix);
 
 	EnableHiddenProfilerSubsystems(pSystem);
+
+	ProfilerTrace::GetInstance().Init();
 }
 
 void Launcher::OnShutdown()
@@ -757,6 +769,7 @@ void Launcher::OnShutdown()
 void Launcher::OnUpdate()
 {
 	Logger::GetInstance().OnUpdate();
+	ProfilerTrace::GetInstance().OnUpdate();
 }
 
 void Launcher::GetMemoryUsage(ICrySizer* pSizer)
@@ -3,6 +3,7 @@
 
 #include <windows.h>
 #include <winhttp.h>
+#include <mmsystem.h>
 
 #include "WinAPI.h"
 #include "StringTools.h"
@@ -502,6 +503,41 @@ void WinAPI::FileWrite(void *handle, const std::string_view & text)
 	while (totalBytesWritten < text.length());
 }
 
+void WinAPI::FileWriteAt(void *handle, uint64_t offset, const std::string_view & text)
+{
+#ifdef BUILD_64BIT
+	if (text.length() >= 0xFFFFFFFF)
+	{
+		throw StringTools::ErrorFormat("Data is too big!");
+	}
+#endif
+
+	size_t totalBytesWritten = 0;
+
+	// make sure everything is written
+	do
+	{
+		const void *buffer = text.data() + totalBytesWritten;
+		const DWORD bufferSize = static_cast<DWORD>(text.length() - totalBytesWritten);
+		const uint64_t position = offset + totalBytesWritten;
+
+		// positioned write, the file pointer shared by other threads is not used
+		OVERLAPPED overlapped = {};
+		overlapped.Offset = static_cast<DWORD>(position);
+		overlapped.OffsetHigh = static_cast<DWORD>(position >> 32);
+
+		DWORD bytesWritten = 0;
+
+		if (!WriteFile(static_cast<HANDLE>(handle), buffer, bufferSize, &bytesWritten, &overlapped))
+		{
+			throw StringTools::SysErrorFormat("WriteFile");
+		}
+
+		totalBytesWritten += bytesWritten;
+	}
+	while (totalBytesWritten < text.length());
+}
+
 uint64_t WinAPI::FileSeek(void *handle, FileSeekBase base, int64_t offset)
 {
 	LARGE_INTEGER offsetValue;
@@ -631,6 +667,47 @@ long WinAPI::GetTimeZoneBias()
 	return 0;
 }
 
+void *WinAPI::WaitableTimerCreate()
+{
+	// CREATE_WAITABLE_TIMER_HIGH_RESOLUTION is missing in older SDKs
+	const DWORD highResolutionFlag = 0x2;
+
+	return CreateWaitableTimerExW(nullptr, nullptr, highResolutionFlag, TIMER_ALL_ACCESS);
+}
+
+void WinAPI::WaitableTimerClose(void *hTimer)
+{
+	CloseHandle(hTimer);
+}
+
+bool WinAPI::WaitableTimerWait(void *hTimer, long long microseconds)
+{
+	LARGE_INTEGER dueTime;
+	dueTime.QuadPart = -microseconds * 10;  // relative time in 100 ns units
+
+	if (!SetWaitableTimer(hTimer, &dueTime, 0, nullptr, nullptr, FALSE))
+	{
+		return false;
+	}
+
+	return WaitForSingleObject(hTimer, INFINITE) == WAIT_OBJECT_0;
+}
+
+bool WinAPI::TimerResolutionBegin(unsigned int milliseconds)
+{
+	return timeBeginPeriod(milliseconds) == TIMERR_NOERROR;
+}
+
+void WinAPI::TimerResolutionEnd(unsigned int milliseconds)
+{
+	timeEndPeriod(milliseconds);
+}
+
+void WinAPI::Sleep(unsigned int milliseconds)
+{
+	::Sleep(milliseconds);
+}
+
 /////////////
 // Strings //
 /////////////
@@ -779,14 +856,8 @@ namespace
 	};
 }
 
-int WinAPI::HTTPRequest(
-	const std::string_view & method,
-	const std::string_view & url,
-	const std::string_view & data,
-	const std::map<std::string, std::string> & headers,
-	int timeout,
-	HTTPRequestCallback callback
-){
+WinAPI::HTTPURLComponents WinAPI::HTTPCrackURL(const std::string_view & url)
+{
 	std::wstring urlW;
 	StringTools::AppendTo(urlW, url);
 
@@ -802,31 +873,81 @@ int WinAPI::HTTPRequest(
 		throw StringTools::SysErrorFormat("WinHttpCrackUrl");
 	}
 
-	HTTPHandleGuard hSession = WinHttpOpen(L"CryMP-Client",
-	                                       WINHTTP_ACCESS_TYPE_NO_PROXY,
-	                                       WINHTTP_NO_PROXY_NAME,
-	                                       WINHTTP_NO_PROXY_BYPASS, 0);
+	HTTPURLComponents result;
+	result.port = urlComponents.nPort;
+	result.isSecure = (urlComponents.nScheme == INTERNET_SCHEME_HTTPS);
+
+	StringTools::AppendTo(result.host, std::wstring_view(urlComponents.lpszHostName, urlComponents.dwHostNameLength));
+
+	// URL components are not null-terminated, but whole URL is, so URL path contains both path and parameters
+	StringTools::AppendTo(result.path, std::wstring_view(urlComponents.lpszUrlPath));
+
+	return result;
+}
+
+void *WinAPI::HTTPSessionOpen(unsigned int maxConnectionsPerServer)
+{
+	HINTERNET hSession = WinHttpOpen(L"CryMP-Client",
+	                                 WINHTTP_ACCESS_TYPE_NO_PROXY,
+	                                 WINHTTP_NO_PROXY_NAME,
+	                                 WINHTTP_NO_PROXY_BYPASS, 0);
 	if (!hSession)
 	{
 		throw StringTools::SysErrorFormat("WinHttpOpen");
 	}
 
-	if (!WinHttpSetTimeouts(hSession, timeout, timeout, timeout, timeout))
+	if (maxConnectionsPerServer)
 	{
-		throw StringTools::SysErrorFormat("WinHttpSetTimeouts");
+		DWORD value = maxConnectionsPerServer;
+
+		// applies to both HTTP/1.0 and HTTP/1.1 servers
+		if (!WinHttpSetOption(hSession, WINHTTP_OPTION_MAX_CONNS_PER_SERVER, &value, sizeof value)
+		 || !WinHttpSetOption(hSession, WINHTTP_OPTION_MAX_CONNS_PER_1_0_SERVER, &value, sizeof value))
+		{
+			const auto error = StringTools::SysErrorFormat("WinHttpSetOption(WINHTTP_OPTION_MAX_CONNS_PER_SERVER)");
+			WinHttpCloseHandle(hSession);
+			throw error;
+		}
 	}
 
-	const std::wstring serverNameW(urlComponents.lpszHostName, urlComponents.dwHostNameLength);
+	return hSession;
+}
 
-	HTTPHandleGuard hConnect = WinHttpConnect(hSession, serverNameW.c_str(), urlComponents.nPort, 0);
+void *WinAPI::HTTPConnectionOpen(void *hSession, const std::string_view & host, unsigned short port)
+{
+	std::wstring hostW;
+	StringTools::AppendTo(hostW, host);
+
+	HINTERNET hConnect = WinHttpConnect(static_cast<HINTERNET>(hSession), hostW.c_str(), port, 0);
 	if (!hConnect)
 	{
 		throw StringTools::SysErrorFormat("WinHttpConnect");
 	}
 
+	return hConnect;
+}
+
+void WinAPI::HTTPHandleClose(void *handle)
+{
+	if (handle)
+	{
+		WinHttpCloseHandle(static_cast<HINTERNET>(handle));
+	}
+}
+
+int WinAPI::HTTPRequest(
+	void *hConnection,
+	bool isSecure,
+	const std::string_view & method,
+	const std::string_view & path,
+	const std::string_view & data,
+	const std::map<std::string, std::string> & headers,
+	int timeout,
+	HTTPRequestCallback callback
+){
 	DWORD requestFlags = WINHTTP_FLAG_REFRESH;
 
-	if (urlComponents.nScheme == INTERNET_SCHEME_HTTPS)
+	if (isSecure)
 	{
 		requestFlags |= WINHTTP_FLAG_SECURE;
 	}
@@ -834,10 +955,12 @@ int WinAPI::HTTPRequest(
 	std::wstring methodW;
 	StringTools::AppendTo(methodW, method);
 
-	// URL components are not null-terminated, but whole URL is, so URL path contains both path and parameters
-	HTTPHandleGuard hRequest = WinHttpOpenRequest(hConnect,
+	std::wstring pathW;
+	StringTools::AppendTo(pathW, path);
+
+	HTTPHandleGuard hRequest = WinHttpOpenRequest(static_cast<HINTERNET>(hConnection),
 	                                              methodW.c_str(),
-	                                              urlComponents.lpszUrlPath, nullptr,
+	                                              pathW.c_str(), nullptr,
 	                                              WINHTTP_NO_REFERER,
 	                                              WINHTTP_DEFAULT_ACCEPT_TYPES, requestFlags);
 	if (!hRequest)
@@ -845,6 +968,12 @@ int WinAPI::HTTPRequest(
 		throw StringTools::SysErrorFormat("WinHttpOpenRequest");
 	}
 
+	// the session may be shared, so timeouts are set per request
+	if (!WinHttpSetTimeouts(hRequest, timeout, timeout, timeout, timeout))
+	{
+		throw StringTools::SysErrorFormat("WinHttpSetTimeouts");
+	}
+
 	std::wstring headersW;
 
 	for (const auto & [key, value] : headers)
@@ -908,12 +1037,29 @@ int WinAPI::HTTPRequest(
 			return dataLength;
 		};
 
-		callback(contentLength, dataReader);
+		callback(statusCode, contentLength, dataReader);
 	}
 
 	return statusCode;
 }
 
+int WinAPI::HTTPRequest(
+	const std::string_view & method,
+	const std::string_view & url,
+	const std::string_view & data,
+	const std::map<std::string, std::string> & headers,
+	int timeout,
+	HTTPRequestCallback callback
+){
+	const HTTPURLComponents urlComponents = HTTPCrackURL(url);
+
+	HTTPHandleGuard hSession = static_cast<HINTERNET>(HTTPSessionOpen());
+	HTTPHandleGuard hConnect = static_cast<HINTERNET>(HTTPConnectionOpen(hSession, urlComponents.host, urlComponents.port));
+
+	return HTTPRequest(hConnect, urlComponents.isSecure, method, urlComponents.path, data, headers, timeout,
+	                   std::move(callback));
+}
+
 ///////////////
 // Clipboard //
 ///////////////
@@ -115,6 +115,7 @@ namespace WinAPI
 
 	std::string FileRead(void *handle, size_t maxLength = 0);
 	void FileWrite(void *handle, const std::string_view & text);
+	void FileWriteAt(void *handle, uint64_t offset, const std::string_view & text);  // thread-safe
 
 	uint64_t FileSeek(void *handle, FileSeekBase base, int64_t offset = 0);
 	void FileResize(void *handle, uint64_t size);
@@ -188,6 +189,11 @@ namespace WinAPI
 			FileWrite(m_handle, text);
 		}
 
+		void WriteAt(uint64_t offset, const std::string_view & text)
+		{
+			FileWriteAt(m_handle, offset, text);
+		}
+
 		uint64_t Seek(FileSeekBase base, int64_t offset = 0)
 		{
 			return FileSeek(m_handle, base, offset);
@@ -232,6 +238,21 @@ namespace WinAPI
 
 	long GetTimeZoneBias();
 
+	// high-resolution waitable timer, requires Windows 10 1803 or later
+	// returns null on failure
+	void *WaitableTimerCreate();
+	void WaitableTimerClose(void *hTimer);
+
+	// blocking, returns false on failure
+	bool WaitableTimerWait(void *hTimer, long long microseconds);
+
+	// system-wide timer resolution used by Sleep
+	// each successful TimerResolutionBegin must be followed by TimerResolutionEnd with the same value
+	bool TimerResolutionBegin(unsigned int milliseconds);
+	void TimerResolutionEnd(unsigned int milliseconds);
+
+	void Sleep(unsigned int milliseconds);
+
 	/////////////
 	// Strings //
 	/////////////
@@ -259,9 +280,40 @@ namespace WinAPI
 	//////////
 
 	using HTTPRequestReader = std::function<size_t(void*,size_t)>;  // buffer, buffer size, returns data length
-	using HTTPRequestCallback = std::function<void(uint64_t,const HTTPRequestReader&)>;  // content length, reader
+	using HTTPRequestCallback = std::function<void(int,uint64_t,const HTTPRequestReader&)>;  // status code, content length, reader
+
+	struct HTTPURLComponents
+	{
+		std::string host;
+		std::string path;  // including parameters
+		unsigned short port = 0;
+		bool isSecure = false;
+	};
+
+	// throws std::system_error
+	HTTPURLComponents HTTPCrackURL(const std::string_view & url);
+
+	// session and connection handles can be shared between threads
+	// WinHTTP keeps alive and reuses TCP/TLS connections of the same session
+	// throw std::system_error
+	void *HTTPSessionOpen(unsigned int maxConnectionsPerServer = 0);  // zero means the WinHTTP default
+	void *HTTPConnectionOpen(void *hSession, const std::string_view & host, unsigned short port);
+	void HTTPHandleClose(void *handle);
+
+	// blocking, returns HTTP status code, throws std::system_error
+	int HTTPRequest(
+		void *hConnection,
+		bool isSecure,
+		const std::string_view & method,
+		const std::string_view & path,
+		const std::string_view & data,
+		const std::map<std::string, std::string> & headers,
+		int timeout,
+		HTTPRequestCallback callback
+	);
 
 	// blocking, returns HTTP status code, throws std::system_error
+	// uses a new session, so nothing is reused between calls
 	int HTTPRequest(
 		const std::string_view & method,
 		const std::string_view & url,